@@ -0,0 +1,141 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - ADC acquisition
+ *
+ *  Timer 3 paces the scans: each match starts a burst over AD0.0 ..
+ *  AD0.(ADC_NCH-1). The ADC interrupt on the last channel stops the burst
+ *  and stores one scan into the active half of a double buffer. When a
+ *  half is full the halves swap and every attached task gets its event
+ *  flag through isr_evt_set(), so consumers sleep until a whole block is
+ *  ready and then read it while the ISR fills the other half.
+ *
+ *  The LPC23xx GPDMA has no ADC request line, so the transfer is done by
+ *  the ISR; it runs ADC_HZ times per second and reads ADC_NCH registers.
+ *
+ *  A block stays valid for one block period after its event. A consumer
+ *  that has not finished by then sees the next block; adc_overruns()
+ *  counts swaps that happened while a consumer had not yet picked up the
+ *  previous block. adc_pace() slows the scans down by a power of two
+ *  while no consumer needs every block; a block then takes that much
+ *  longer.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Clock.h"
+#include "Adc.h"
+#include "Trace.h"
+#include "Vic.h"
+
+#define ADC_SEL         ((1 << ADC_NCH) - 1)
+#define ADC_CLKDIV      2           /* ADC clock = 12 MHz/3 = 4 MHz */
+#define ADC_CR_RUN      (ADC_SEL | (ADC_CLKDIV << 8) | (1 << 21))
+#define ADC_BURST       (1 << 16)
+
+static U16 adc_buf[2][ADC_BLK][ADC_NCH];
+static U32 adc_fill;                /* half being filled by the ISR */
+static U32 adc_idx;                 /* next scan in that half */
+static volatile U32 adc_ready;      /* last completed half */
+static volatile U32 adc_seq;        /* completed blocks */
+static volatile U32 adc_taken;      /* adc_seq when last read */
+static volatile U32 adc_overrun;
+static volatile U32 adc_time;       /* clk_now() of the last swap */
+
+static OS_TID adc_tid[ADC_SUBS];
+static U16    adc_evt[ADC_SUBS];
+
+/* Pacing timer: start one burst scan */
+static __irq void adc_timer_irq(void) {
+  T3IR   = 1;
+  AD0CR  = ADC_CR_RUN | ADC_BURST;
+  VICVectAddr = 0;
+}
+
+/* Last channel done: the whole scan is in AD0DR0..n */
+static __irq void adc_irq(void) {
+  U16 *scan = adc_buf[adc_fill][adc_idx];
+  volatile unsigned long *dr = &AD0DR0;     /* AD0DR0..7 are contiguous */
+  int i;
+
+  AD0CR = ADC_CR_RUN;               /* stop burst */
+  TRACE(TRC_ISR, 18, adc_idx);
+  for (i = 0; i < ADC_NCH; i++) {
+    scan[i] = (dr[i] >> 6) & 0x3FF; /* also clears DONE */
+  }
+
+  if (++adc_idx == ADC_BLK) {
+    if (adc_taken != adc_seq) adc_overrun++;
+    adc_ready = adc_fill;
+    adc_fill ^= 1;
+    adc_idx   = 0;
+    adc_seq++;
+    adc_time  = clk_now();
+    for (i = 0; i < ADC_SUBS; i++) {
+      if (adc_tid[i]) isr_evt_set(adc_evt[i], adc_tid[i]);
+    }
+  }
+  VICVectAddr = 0;
+}
+
+/* Wake 'tid' with 'evt' after every block. Returns 0 if the table is
+   full. Call before adc_init(). */
+int adc_attach(OS_TID tid, U16 evt) {
+  int i;
+
+  for (i = 0; i < ADC_SUBS; i++) {
+    if (adc_tid[i] == 0) {
+      adc_evt[i] = evt;
+      adc_tid[i] = tid;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Power up the ADC and start paced scanning */
+void adc_init(void) {
+  PCONP    |= (1 << 12);            /* power ADC */
+  PINSEL1   = (PINSEL1 & ~(0xF << 14)) | (0x5 << 14);  /* AD0.0, AD0.1 */
+  AD0CR     = ADC_CR_RUN;
+  AD0INTEN  = (1 << (ADC_NCH - 1)); /* interrupt on last channel only */
+  VICVectAddr18 = (U32)adc_irq;
+  VICVectCntl18 = 12;
+  VICIntEnable  = (1 << 18);
+
+  PCONP    |= (1 << 23);            /* power Timer 3 */
+  T3TCR     = 2;
+  T3MR0     = CLK_HZ / ADC_HZ - 1;
+  T3MCR     = 3;                    /* interrupt and reset on MR0 */
+  VICVectAddr27 = (U32)adc_timer_irq;
+  VICVectCntl27 = 13;
+  VICIntEnable  = (1 << 27);
+  T3TCR     = 1;
+}
+
+/* One scan every 2^shift pacing periods. Going faster restarts the
+   count, which may already be past the new match. */
+void adc_pace(U32 shift) {
+  U32 mr = ((CLK_HZ / ADC_HZ) << shift) - 1;
+  U32 was;
+
+  if (mr == T3MR0) return;
+  was = vic_lock(VIC_TIMER3);
+  if (mr < T3MR0) T3TC = 0;
+  T3MR0 = mr;
+  vic_unlock(was);
+}
+
+/* Last completed block, adc_block()[scan*ADC_NCH + ch] */
+const U16 *adc_block(void) {
+  adc_taken = adc_seq;
+  return &adc_buf[adc_ready][0][0];
+}
+
+/* clk_now() at which the last block completed */
+U32 adc_stamp(void) {
+  return adc_time;
+}
+
+/* Number of blocks replaced before a consumer read them */
+U32 adc_overruns(void) {
+  return adc_overrun;
+}
@@ -0,0 +1,24 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - ADC acquisition definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __ADC_H
+#define __ADC_H
+
+/* Scanned AD0 channels (AD0.0 is the MCB2300 potentiometer) */
+#define ADC_CH_TEMP     0           /* AD0.0, P0.23 */
+#define ADC_CH_LIGHT    1           /* AD0.1, P0.24 */
+#define ADC_NCH         2           /* channels 0..ADC_NCH-1 are scanned */
+
+#define ADC_HZ          100         /* scans per second */
+#define ADC_BLK         50          /* scans per block (0.5 s) */
+#define ADC_SUBS        4           /* max. tasks woken per block */
+
+extern void adc_init (void);
+extern int  adc_attach (OS_TID tid, U16 evt);
+extern const U16 *adc_block (void);
+extern U32  adc_stamp (void);
+extern void adc_pace (U32 shift);
+extern U32  adc_overruns (void);
+
+#endif
@@ -1,412 +1,649 @@
-/*----------------------------------------------------------------------------
- *  Smart Home System - RTOS Concepts Demo (Simulated Sensors)
- *  Added: Simulated ICPP (Immediate Ceiling Priority Protocol)
- *         Simulated OCPP (Original Ceiling Priority Protocol)
- *
- *  NOTE: This is a *simulation* of ceiling protocols for demonstration.
- *  It does not change the RTOS scheduler priority levels (no kernel API
- *  calls are used). Instead it enforces mutual exclusion using a small
- *  ceiling manager and a mutex. To implement real priority elevation you
- *  should use the RTOS API to change task priorities while holding the
- *  protected resource.
- *----------------------------------------------------------------------------*/
-
-#include <RTL.h>
-#include <LPC23xx.H>
-#include "LCD.h"
-#include <stdio.h>
-#include <string.h>
-
-/* ---------------- Task IDs ---------------- */
-OS_TID t_temp;
-OS_TID t_light;
-OS_TID t_motion;
-OS_TID t_display;
-OS_TID t_logger;
-OS_TID t_emergency;
-OS_TID t_clock;
-
-/* ---------------- Event Flags -------------- */
-#define EVT_TEMP_UPDATE   0x0001
-#define EVT_LIGHT_UPDATE  0x0002
-#define EVT_MOTION        0x0004
-#define EVT_CLOCK         0x0100
-
-/* ---------------- LEDs -------------------- */
-#define LED_TEMP_MASK   0x0F    /* P2.0 - P2.3  (Fan) */
-#define LED_LIGHT_MASK  0x70    /* P2.4 - P2.6  (Room Light) */
-#define LED_CLK         0x80    /* P2.7 clock/motion */
-
-/* ---------------- Shared State ------------- */
-volatile unsigned int sensor_temp = 20;     /* Celsius (simulated) */
-volatile unsigned int sensor_light = 50;    /* 0=bright 100=dark */
-volatile unsigned char motion_detected = 0;
-volatile U8 emergency_flag = 0;
-
-/* ---------------- RTOS Objects ------------- */
-OS_MUT mut_lcd;
-OS_SEM sem_sensors;
-
-#define MSGBOX_SIZE 5
-void *msgbox[MSGBOX_SIZE];
-#define LOG_MSG_LEN 40
-static char log_pool[MSGBOX_SIZE][LOG_MSG_LEN];
-static int log_pool_put = 0;
-static int log_pool_get = 0;
-
-/* ---------------- Ceiling Simulation ------- */
-/*
-  We provide a small simulation for ICPP and OCPP.
-  - ICPP (Immediate Ceiling): when a task acquires the resource it
-    immediately acquires the resource ceiling and sets a global owner.
-    Other tasks that try to enter will be blocked until release.
-  - OCPP (Original Ceiling): a resource has a ceiling value and a task
-    can only lock it if its priority is higher (numerically lower) than
-    the current system ceiling. Here we simulate by a global ceiling and
-    simple checks.
-
-  This simulation uses a mutex (mut_ceiling) to protect the ceiling state.
-*/
-
-OS_MUT mut_ceiling; /* protect ceiling manager state */
-volatile OS_TID ceiling_owner = 0; /* owner tid for ICPP */
-volatile int system_ceiling = 0; /* current system ceiling (0=none) */
-
-/* Optional per-task base priority mapping (used for OCPP simulation).
-   We record base priority when tasks are created. */
-#define MAX_TASKS 12
-typedef struct { OS_TID tid; int base_prio; } TASKINFO;
-static TASKINFO task_table[MAX_TASKS];
-static int task_table_count = 0;
-
-/* Register task id and its base priority (call after os_tsk_create) */
-void register_task(OS_TID tid, int prio) {
-  if (task_table_count < MAX_TASKS) {
-    task_table[task_table_count].tid = tid;
-    task_table[task_table_count].base_prio = prio;
-    task_table_count++;
-  }
-}
-
-/* Find base priority by tid (returns large value if not found) */
-int get_base_priority(OS_TID tid) {
-  int i;
-  for (i = 0; i < task_table_count; i++) {
-    if (task_table[i].tid == tid) return task_table[i].base_prio;
-  }
-  return 0x7fffffff;
-}
-
-/* ---------- ICPP Simulation ---------- */
-int icpp_acquire(OS_TID self) {
-  /* Acquire ceiling manager mutex */
-  if (os_mut_wait(&mut_ceiling, 0xffff) != OS_R_OK) return 0;
-  if (ceiling_owner == 0) {
-    ceiling_owner = self;
-    os_mut_release(&mut_ceiling);
-    return 1; /* success */
-  }
-  /* already owned */
-  os_mut_release(&mut_ceiling);
-  return 0; /* failure */
-}
-
-void icpp_release(OS_TID self) {
-  if (os_mut_wait(&mut_ceiling, 0xffff) != OS_R_OK) return;
-  if (ceiling_owner == self) ceiling_owner = 0;
-  os_mut_release(&mut_ceiling);
-}
-
-/* ---------- OCPP Simulation ---------- */
-/* For OCPP we use a per-resource ceiling value. Here we pass a ceiling
-   priority (lower numeric value = higher priority in our task creation).
-   A task may obtain resource only if its base priority is <= resource_ceiling
-   and also the system_ceiling allows it.
-*/
-int ocpp_acquire(OS_TID self, int resource_ceiling) {
-  int myprio = get_base_priority(self);
-  int acquired = 0;
-  if (os_mut_wait(&mut_ceiling, 0xffff) != OS_R_OK) return 0;
-
-  /* Check if my priority meets the resource's ceiling requirement */
-  if (myprio <= resource_ceiling && (system_ceiling == 0 || myprio <= system_ceiling)) {
-    /* raise system ceiling to resource_ceiling (simulate non-preemptive effect) */
-    system_ceiling = resource_ceiling;
-    acquired = 1;
-  }
-
-  os_mut_release(&mut_ceiling);
-  return acquired;
-}
-
-void ocpp_release(OS_TID self, int resource_ceiling) {
-  if (os_mut_wait(&mut_ceiling, 0xffff) != OS_R_OK) return;
-  /* Only lower system ceiling if it matches this resource (simple model) */
-  if (system_ceiling == resource_ceiling) system_ceiling = 0;
-  os_mut_release(&mut_ceiling);
-}
-
-/* ---------------- LED Helpers -------------- */
-void update_temp_leds(int level) {
-  unsigned int bits;
-  switch (level) {
-    case 0: bits = 0x01; break;
-    case 1: bits = 0x03; break;
-    case 2: bits = 0x07; break;
-    case 3: bits = 0x0F; break;
-    default: bits = 0x01; break;
-  }
-  FIO2CLR = LED_TEMP_MASK;
-  FIO2SET = bits & LED_TEMP_MASK;
-}
-
-void update_light_leds(int level) {
-  unsigned int bits;
-  switch (level) {
-    case 0: bits = 0x00; break;
-    case 1: bits = 0x10; break;
-    case 2: bits = 0x30; break;
-    case 3: bits = 0x70; break;
-    default: bits = 0x10; break;
-  }
-  FIO2CLR = LED_LIGHT_MASK;
-  FIO2SET = bits & LED_LIGHT_MASK;
-}
-
-/* ---------------- Tasks ------------------- */
-
-/* Temperature Task  Simulated increasing/decreasing temperature
-   Uses ICPP to protect LED update region (simulated immediate ceiling).
-*/
-__task void temp_task(void) {
-  unsigned int temp = 20;
-  unsigned char rising = 1;
-  char buf[LOG_MSG_LEN];
-  int level;
-  int idx;
-  OS_TID self = os_tsk_self();
-
-  for (;;) {
-    /* simulate temperature rising/falling */
-    if (rising) temp++;
-    else temp--;
-    if (temp >= 40) rising = 0;
-    if (temp <= 20) rising = 1;
-
-    /* protect shared state */
-    if (os_sem_wait(&sem_sensors, 50) == OS_R_OK) {
-      sensor_temp = temp;
-      os_sem_send(&sem_sensors);
-    }
-
-    /* map to fan level */
-    if (temp < 25) level = 0;
-    else if (temp < 30) level = 1;
-    else if (temp < 35) level = 2;
-    else level = 3;
-
-    /* ---- ICPP protected LED update ---- */
-    /* Try to acquire immediate ceiling. If busy, wait briefly and retry.
-       In a real ICPP you'd raise task priority via kernel APIs so preemption
-       cannot happen while holding the resource. */
-    while (!icpp_acquire(self)) os_dly_wait(5);
-    update_temp_leds(level);
-    icpp_release(self);
-    /* ------------------------------------ */
-
-    /* log message */
-    idx = log_pool_put % MSGBOX_SIZE;
-    sprintf(log_pool[idx], "Temp:%dC Fan:%d", temp, level);
-    if (os_mbx_send(&msgbox, (void*)log_pool[idx], 40) == OS_R_OK)
-      log_pool_put++;
-
-    os_evt_set(EVT_TEMP_UPDATE, t_display);
-    os_dly_wait(200);
-  }
-}
-
-/* Light Task  Simulated day/night cycle + all LEDs on motion
-   Uses OCPP to protect light LED updates (simulated resource ceiling).
-   Here resource ceiling is chosen as "2" meaning tasks with base priority
-   <= 2 are allowed to lock it. (Lower numeric value = higher priority in
-   this demo; we assume created priorities follow that convention.)
-*/
-__task void light_task(void) {
-  unsigned int light = 50;
-  unsigned char darkening = 1;
-  char buf[LOG_MSG_LEN];
-  int level;
-  int idx;
-  OS_TID self = os_tsk_self();
-  const int LIGHT_RESOURCE_CEILING = 2; /* example ceiling */
-
-  for (;;) {
-    /* simulate day-night */
-    if (darkening) light += 5; else light -= 5;
-    if (light >= 90) darkening = 0;
-    if (light <= 10) darkening = 1;
-
-    /* protect shared state */
-    if (os_sem_wait(&sem_sensors, 50) == OS_R_OK) {
-      sensor_light = light;
-      os_sem_send(&sem_sensors);
-    }
-
-    if (light < 25) level = 0;
-    else if (light < 50) level = 1;
-    else if (light < 75) level = 2;
-    else level = 3;
-
-    /* ---- Motion Override + OCPP Handling ---- */
-    /* Motion override: when motion is detected we want to ensure ALL LEDs
-       light up regardless of the simulated OCPP ceiling. This gives motion
-       detection higher functional priority (safe override). */
-    if (motion_detected) {
-      /* immediate override: turn all LEDs ON for a short flash */
-      FIO2SET = 0xFF;
-      os_dly_wait(100);
-      FIO2CLR = 0xFF;
-    } else {
-      /* Normal OCPP-protected behavior for light updates */
-      if (ocpp_acquire(self, LIGHT_RESOURCE_CEILING)) {
-        update_light_leds(level);
-        ocpp_release(self, LIGHT_RESOURCE_CEILING);
-      } else {
-        /* Could not acquire OCPP resource  perform a safe non-critical update */
-        update_light_leds(level);
-      }
-    }
-    /* -------------------------- */
-
-    /* log */
-    idx = log_pool_put % MSGBOX_SIZE;
-    sprintf(log_pool[idx], "Light:%u Level:%d", light, level);
-    if (os_mbx_send(&msgbox, (void*)log_pool[idx], 40) == OS_R_OK)
-      log_pool_put++;
-
-    os_evt_set(EVT_LIGHT_UPDATE, t_display);
-    /* check more frequently so motion windows are not missed */
-    os_dly_wait(50);
-  }
-}
-
-/* Motion Task  Simulated periodic motion detection */
-__task void motion_task(void) {
-  for (;;) {
-    os_dly_wait(800);
-    motion_detected = 1;
-    os_evt_set(EVT_MOTION, t_light);
-    os_evt_set(EVT_MOTION, t_display);
-    /* extend motion duration so light_task has time to observe it */
-    os_dly_wait(400);
-    motion_detected = 0;
-  }
-}
-
-/* Display Task  shows sensor readings on LCD */
-__task void display_task(void) {
-  char line[40];
-  unsigned int temp, light;
-  unsigned char motion;
-
-  for (;;) {
-    os_evt_wait_or(EVT_TEMP_UPDATE | EVT_LIGHT_UPDATE | EVT_MOTION, 200);
-    if (os_sem_wait(&sem_sensors, 50) == OS_R_OK) {
-      temp = sensor_temp;
-      light = sensor_light;
-      motion = motion_detected;
-      os_sem_send(&sem_sensors);
-
-      if (os_mut_wait(&mut_lcd, 100) == OS_R_OK) {
-        LCD_cls();
-        sprintf(line, "T:%dC L:%u M:%u", temp, light, motion);
-        LCD_puts((U8*)line);
-        os_mut_release(&mut_lcd);
-      }
-    }
-  }
-}
-
-/* Logger Task  prints last system log */
-__task void logger_task(void) {
-  void *msg;
-  for (;;) {
-    if (os_mbx_wait(&msgbox, &msg, 120) == OS_R_OK) {
-      if (os_mut_wait(&mut_lcd, 100) == OS_R_OK) {
-        LCD_gotoxy(1,2);
-        LCD_puts((U8*)"Log:");
-        LCD_puts((U8*)msg);
-        os_mut_release(&mut_lcd);
-      }
-      log_pool_get++;
-    } else os_dly_wait(30);
-  }
-}
-
-/* Emergency Task  shows overheating warning if needed */
-__task void emergency_task(void) {
-  for (;;) {
-    if (sensor_temp > 45) emergency_flag = 1;
-    else emergency_flag = 0;
-
-    if (emergency_flag) {
-      if (os_mut_wait(&mut_lcd, 0xffff) == OS_R_OK) {
-        LCD_cls();
-        LCD_puts((U8*)"!!! OVERHEAT !!!");
-        os_mut_release(&mut_lcd);
-      }
-      FIO2SET = 0xFF; os_dly_wait(10);
-      FIO2CLR = 0xFF; os_dly_wait(10);
-    }
-    os_dly_wait(50);
-  }
-}
-
-/* Clock Task  simple LED heartbeat */
-__task void clock_task(void) {
-  for (;;) {
-    FIO2SET = LED_CLK; os_dly_wait(5);
-    FIO2CLR = LED_CLK; os_dly_wait(95);
-  }
-}
-
-/* Init Task */
-__task void init(void) {
-  FIO2DIR = 0xFF;
-  FIO2CLR = 0xFF;
-  PINSEL10 = 0;
-
-  os_sem_init(&sem_sensors, 1);
-  os_mut_init(&mut_lcd);
-  os_mut_init(&mut_ceiling);
-  os_mbx_init(&msgbox, MSGBOX_SIZE);
-
-  LCD_init();
-  LCD_cur_off();
-  LCD_cls();
-  LCD_puts((U8*)"Smart Home System");
-
-  /* Create tasks, note the numeric priority (lower = higher priority in
-     the demo). Keep same priorities as original code. */
-  t_temp      = os_tsk_create(temp_task, 3);
-  register_task(t_temp, 3);
-  t_light     = os_tsk_create(light_task, 4);
-  register_task(t_light, 4);
-  t_motion    = os_tsk_create(motion_task, 2);
-  register_task(t_motion, 2);
-  t_display   = os_tsk_create(display_task, 5);
-  register_task(t_display, 5);
-  t_logger    = os_tsk_create(logger_task, 6);
-  register_task(t_logger, 6);
-  t_emergency = os_tsk_create(emergency_task, 1);
-  register_task(t_emergency, 1);
-  t_clock     = os_tsk_create(clock_task, 7);
-  register_task(t_clock, 7);
-
-  os_tsk_delete_self();
-}
-
-/* Main */
-int main(void) {
-  os_sys_init(init);
-}
+/*----------------------------------------------------------------------------
+ *  Smart Home System - RTOS Concepts Demo (Simulated Sensors)
+ *  Added: ICPP (Immediate Ceiling Priority Protocol)
+ *         OCPP (Original Ceiling Priority Protocol)
+ *
+ *  NOTE: The ceiling protocols are implemented by the resource manager in
+ *  Ceiling.c, which changes the RTX task priorities while a resource is
+ *  held. RTX priorities are used as is: a larger number is a higher
+ *  priority. The flash log is the shared resource (ICPP): the logger
+ *  programs and erases it, the serial task reads it back. The LEDs no
+ *  longer need a resource: every writer owns its own bits in the output
+ *  manager (Output.c).
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "LCD.h"
+#include "Log.h"
+#include "Flog.h"
+#include "TaskReg.h"
+#include "Ceiling.h"
+#include "Sensor.h"
+#include "Clock.h"
+#include "Profile.h"
+#include "Adc.h"
+#include "Filter.h"
+#include "Output.h"
+#include "History.h"
+#include "Sched.h"
+#include "Latency.h"
+#include "Serial.h"
+#include "Trace.h"
+#include "Telem.h"
+#include "Wheel.h"
+#include "SensTab.h"
+#include "Screen.h"
+#include "Health.h"
+#include "Rule.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ---------------- Sensor Source ----------- */
+/* 1: temperature and light from AD0.0/AD0.1 (Adc.c)
+   0: simulated ramps, for runs without analog inputs */
+#ifndef SENSOR_ADC
+#define SENSOR_ADC        1
+#endif
+
+#define TEMP_BLOCKS       4     /* ADC blocks per temperature sample (2 s) */
+#define TEMP_SCALE        50    /* ADC full scale: 50 Celsius */
+#define LIGHT_SCALE       100   /* ADC full scale: 100 (0=bright 100=dark) */
+
+/* ---------------- Filters / Levels -------- */
+/* Decimate raw ADC samples to the sensor rate, smooth with an EMA, then
+   map to levels with hysteresis: fan 25/30/35 C (1 C band), light
+   25/50/75 (3 band). */
+static const U16 temp_thr[]  = { 25, 30, 35 };
+static const U16 light_thr[] = { 25, 50, 75 };
+static LEVELS temp_lvl  = LVL_INIT(temp_thr, 1);
+static LEVELS light_lvl = LVL_INIT(light_thr, 3);
+
+/* ---------------- History ---------------- */
+/* Both series store one sample per 2 s (temperature every sample, light
+   the mean of 4), so HIST_LEN covers about 34 minutes (17 with
+   CFG_MINIMAL, see Config.h). The display shows
+   10 minute windows. */
+#define HIST_SEC          2
+#define HIST_WIN          (600 / HIST_SEC)
+
+#if (SENSOR_ADC)
+static FILTER temp_filt  = FILT_INIT(ADC_BLK * TEMP_BLOCKS, 2);
+static FILTER light_filt = FILT_INIT(ADC_BLK, 2);
+#define TEMP_FILT         (&temp_filt)
+#define LIGHT_FILT        (&light_filt)
+#define TEMP_READ         NULL      /* ADC channel through the filter */
+#define LIGHT_READ        NULL
+#else
+#define TEMP_FILT         NULL
+#define LIGHT_FILT        NULL
+#define TEMP_READ         temp_sim
+#define LIGHT_READ        light_sim
+#endif
+
+/* ---------------- Task Table -------------- */
+/* Priorities are derived from the deadlines by sched_start() (shorter
+   deadline = higher priority, ties in table order); init runs above all
+   of them while it creates the tasks. Deadlines are in ticks (10 ms),
+   stack sizes in bytes: display, logger and serial run sprintf, the
+   logger also calls IAP (up to 128 bytes of stack), the others only call
+   RTX and small helpers. Re-check the peaks reported by tsk_stack_used()
+   (INT0 readout) on target before trimming further.
+
+   The sensor workers (SensTab.c) take the tightest deadline of the
+   sensor table below. The LCD server (Screen.c) shares emergency_task's
+   deadline and so runs just below it: the overheat banner is drawn as
+   soon as it is posted. Periodic housekeeping (sensor releases, the
+   motion flash, the heartbeat) runs from the timer wheel interrupt
+   (Wheel.c) and needs no task. The health monitor (Health.c) comes
+   last: it feeds the watchdog, so it has to find time below all the
+   others. */
+#define PRIO_INIT         254
+
+/* Heartbeat budgets [ticks]: the longest a task may go without a beat
+   outside its main wait. All but serial are critical: a stuck UART link
+   is logged but does not reset the controller. */
+#define HB_BUDGET         100
+#define HB_BUDGET_LCD     50
+#define HB_BUDGET_SERIAL  200
+
+#if (SENSOR_ADC)
+#define TEMP_PERIOD       0
+#define LIGHT_PERIOD      0
+#define TEMP_DEADLINE     50
+#else
+#define TEMP_PERIOD       200
+#define LIGHT_PERIOD      50
+#define TEMP_DEADLINE     200
+#endif
+#define MOTION_PERIOD     400
+#define SENS_BACK         3         /* quiet temp/light: up to 8x period */
+#define TEMP_DBAND        1         /* change that ends a backoff [C] */
+#define LIGHT_DBAND       2
+#define MOTION_FLASH      100       /* all LEDs on after motion [ticks] */
+#define CLOCK_PERIOD      100       /* heartbeat [ticks] */
+#define CLOCK_ON          5         /* LED_CLK on time [ticks] */
+
+/*        name       function        deadline  stack */
+#define TASKS(X) \
+        X(sensor0,   stab_worker,    50,       192) \
+        X(sensor1,   stab_worker,    50,       192) \
+        X(display,   display_task,   100,      320) \
+        X(logger,    logger_task,    500,      384) \
+        X(emergency, emergency_task, 10,       160) \
+        X(lcd,       scr_server,     10,       192) \
+        X(serial,    serial_task,    1000,     288) \
+        X(health,    hb_monitor,     1000,     160)
+
+TASKS(SCHED_TID)                    /* OS_TID t_sensor0, t_sensor1, ... */
+TASKS(SCHED_STK)
+TASKS(SCHED_PROTO)
+
+static const TASK_DEF task_tab[] = {
+  TASKS(SCHED_DEF)
+};
+
+/* ---------------- Event Flags -------------- */
+#define EVT_TEMP_UPDATE   0x0001
+#define EVT_LIGHT_UPDATE  0x0002
+#define EVT_MOTION        0x0004
+#define EVT_OVERHEAT      0x0008
+#define EVT_COOLED        0x0010
+#define EVT_PROF          0x0020   /* INT0 button: show next profile line */
+#define EVT_SERIAL        0x0080   /* UART0 bytes received */
+#define EVT_TELEM         0x0200   /* new sensor value for telemetry */
+
+/* ---------------- LEDs -------------------- */
+#define LED_TEMP_MASK   0x0F    /* P2.0 - P2.3  (Fan) */
+#define LED_LIGHT_MASK  0x70    /* P2.4 - P2.6  (Room Light) */
+#define LED_CLK         0x80    /* P2.7 clock/motion */
+
+/* ---------------- Shared State ------------- */
+/* Sensor values live in Sensor.c (sens_write/sens_read). */
+#define OVERHEAT_TEMP     45    /* Celsius, emergency above this */
+volatile U8 emergency_flag = 0;
+
+/* The flash log: programmed and erased by logger_task, read back by
+   serial_task ('P'). A read checks a segment header, then a record and
+   its page's time mark; an erase by the (higher priority) logger in
+   between would mix segments. ICPP with the ceiling of the two tasks:
+   a reader is never preempted by the logger while it holds the log,
+   and the logger waits at most for one record read. */
+static RES flog_res;
+
+/* ---------------- Latency ----------------- */
+/* Response times of the sensor and display jobs, and the time from the
+   motion release to the LED flash. */
+static LAT_TASK lat_temp;
+static LAT_TASK lat_light;
+static LAT_TASK lat_display;
+static LAT_HIST lat_motion;
+static volatile U32 disp_rel;       /* clk_now() of the first pending post */
+static volatile U8  disp_pend;
+
+/* Post an update to display_task, stamping the first pending one */
+static void display_post(U16 evt) {
+  tsk_lock();
+  if (!disp_pend) {
+    disp_rel  = clk_now();
+    disp_pend = 1;
+  }
+  tsk_unlock();
+  os_evt_set(evt, t_display);
+}
+
+/* ---------------- LED Patterns ------------- */
+/* Output bits per level */
+static const U8 fan_bits[]   = { 0x01, 0x03, 0x07, 0x0F };
+static const U8 light_bits[] = { 0x00, 0x10, 0x30, 0x70 };
+
+/* ---------------- Sensor Sources / Notes --- */
+#if (!SENSOR_ADC)
+#define SIM_FALL          0x80000000u
+
+/* Triangle wave lo..hi, one step per sample; r->src holds the value,
+   SIM_FALL while going down */
+static U32 sim_ramp(STAB_RUN *r, U32 lo, U32 hi, U32 step) {
+  U32 fall = r->src & SIM_FALL;
+  U32 v    = r->src & ~SIM_FALL;
+
+  if (v < lo) v = lo;
+  v = fall ? v - step : v + step;
+  if (v >= hi) fall = SIM_FALL;
+  if (v <= lo) fall = 0;
+  r->src = v | fall;
+  return v;
+}
+
+/* Simulated temperature rising and falling between 20 and 40 C */
+static int temp_sim(STAB_RUN *r, U32 *value) {
+  *value = sim_ramp(r, 20, 40, 1);
+  return 1;
+}
+
+/* Simulated day-night between 10 and 90 */
+static int light_sim(STAB_RUN *r, U32 *value) {
+  *value = sim_ramp(r, 10, 90, 5);
+  return 1;
+}
+#endif
+
+/* Simulated motion detection: 2 periods quiet, 1 period motion */
+static int motion_sim(STAB_RUN *r, U32 *value) {
+  if (++r->src == 3) r->src = 0;
+  *value = (r->src == 2);
+  return 1;
+}
+
+/* Temperature and light: telemetry and the display bars on every value.
+   Overheat crossings reach emergency_task through the rules. */
+static void level_note(STAB_RUN *r, int changed) {
+  (void)changed;                    /* both follow every value */
+  os_evt_set(EVT_TELEM, t_serial);
+  display_post(r->def->sens == SENS_TEMP ? EVT_TEMP_UPDATE : EVT_LIGHT_UPDATE);
+}
+
+/* Motion Override: when motion is detected ALL LEDs light up for a
+   short flash, which gives motion detection higher functional priority
+   (safe override). The flash is a pulse rule (rule_tab below): it ends
+   from the timer wheel interrupt and releasing it shows the fan, light
+   and clock LEDs as they were. By the time the note runs the rule has
+   lit the LEDs, so the latency is motion release to LED. */
+static void motion_note(STAB_RUN *r, int changed) {
+  if (!changed || !r->value) return;
+  lat_add(&lat_motion, clk_now() - r->rel);
+  stab_kick(r->def->room);          /* someone is home: full rate */
+}
+
+/* ---------------- Heartbeat --------------- */
+/* LED_CLK on for CLOCK_ON ticks every CLOCK_PERIOD, from the timer
+   wheel interrupt: a periodic timer switches it on and starts the
+   one-shot that switches it off. */
+static WHEEL_TMR beat_tmr;
+static WHEEL_TMR beat_off_tmr;
+
+static void beat_off(WHEEL_TMR *t) {
+  (void)t;
+  out_set(OUT_CLOCK, LED_CLK, 0);
+}
+
+static void beat_on(WHEEL_TMR *t) {
+  (void)t;
+  out_set(OUT_CLOCK, LED_CLK, LED_CLK);
+  wheel_start(&beat_off_tmr, CLOCK_ON, 0);
+}
+
+/* ---------------- Sensor Table ------------- */
+/* One row per sensor of every room, serviced by the sensor workers;
+   another room is more rows, not more tasks. With SENSOR_ADC temp and
+   light are released by every ADC block (one per 50 ticks) and must
+   take it before the next one lands. Temp and light back off to
+   SENS_BACK periods (blocks) while they stay within their deadband and
+   return to full rate when they move or motion is seen in the room. */
+static const STAB_DEF sens_tab[] = {
+  /* name     room sens         ch            scale        period         deadline
+     filt        lvl         lvl_sens
+     hist        log            log_id        lat         read        note
+     back_max    dband */
+  { "temp",   0,   SENS_TEMP,   ADC_CH_TEMP,  TEMP_SCALE,  TEMP_PERIOD,   TEMP_DEADLINE,
+    TEMP_FILT,  &temp_lvl,  SENS_FAN,
+    HIST_TEMP,  LOG_SRC_TEMP,  LOG_ID_TEMP,  &lat_temp,  TEMP_READ,  level_note,
+    SENS_BACK,  TEMP_DBAND },
+  { "light",  0,   SENS_LIGHT,  ADC_CH_LIGHT, LIGHT_SCALE, LIGHT_PERIOD,  50,
+    LIGHT_FILT, &light_lvl, SENS_LAMP,
+    HIST_LIGHT, LOG_SRC_LIGHT, LOG_ID_LIGHT, &lat_light, LIGHT_READ, level_note,
+    SENS_BACK,  LIGHT_DBAND },
+  { "motion", 0,   SENS_MOTION, STAB_NONE,    0,           MOTION_PERIOD, MOTION_PERIOD,
+    NULL,       NULL,       STAB_NONE,
+    STAB_NONE,  STAB_NONE,     0,            NULL,       motion_sim, motion_note,
+    0,          0 }
+};
+
+#define SENS_ROWS         (sizeof(sens_tab) / sizeof(sens_tab[0]))
+static STAB_RUN sens_run[SENS_ROWS];
+
+/* ---------------- Rules ------------------- */
+/* Automations, run by the writer of a value when it changes (Rule.c):
+   fan and light LEDs per level, the motion flash, the overheat event,
+   log record and banner, and the display and telemetry updates on
+   motion. The flashing itself needs a task (emergency_task). */
+#define OVERHEAT_TEXT     SCR_BELL "   OVERHEAT   " SCR_BELL
+
+static const RULE rule_tab[] = {
+  /* sens        op           level
+     on
+     off */
+  { SENS_FAN,    RULE_CHANGE, 0,
+    RULE_DO_MAP(OUT_FAN, LED_TEMP_MASK, fan_bits),
+    RULE_DO_NOP },
+  { SENS_LAMP,   RULE_CHANGE, 0,
+    RULE_DO_MAP(OUT_LIGHT, LED_LIGHT_MASK, light_bits),
+    RULE_DO_NOP },
+  { SENS_MOTION, RULE_ABOVE,  0,
+    RULE_DO_PULSE(OUT_MOTION, OUT_PINS, OUT_PINS, MOTION_FLASH),
+    RULE_DO_NOP },
+  { SENS_MOTION, RULE_CHANGE, 0,
+    RULE_DO_EVT(t_display, EVT_MOTION),
+    RULE_DO_NOP },
+  { SENS_MOTION, RULE_CHANGE, 0,
+    RULE_DO_EVT(t_serial, EVT_TELEM),
+    RULE_DO_NOP },
+  { SENS_TEMP,   RULE_ABOVE,  OVERHEAT_TEMP,
+    RULE_DO_EVT(t_emergency, EVT_OVERHEAT),
+    RULE_DO_EVT(t_emergency, EVT_COOLED) },
+  { SENS_TEMP,   RULE_ABOVE,  OVERHEAT_TEMP,
+    RULE_DO_LOG(LOG_SRC_EMERG, LOG_ID_OVERHEAT, 1),
+    RULE_DO_LOG(LOG_SRC_EMERG, LOG_ID_OVERHEAT, 0) },
+  { SENS_TEMP,   RULE_ABOVE,  OVERHEAT_TEMP,
+    RULE_DO_ALARM(OVERHEAT_TEXT),
+    RULE_DO_ALARM(NULL) }
+};
+
+#define RULE_ROWS         (sizeof(rule_tab) / sizeof(rule_tab[0]))
+static RULE_RUN rule_run[RULE_ROWS];
+
+/* ---------------- Button ------------------ */
+/* INT0 button (P2.10) as EINT0, falling edge: asks display_task to show
+   the profiler line of the next task. */
+__irq void button_irq(void) {
+  EXTINT = 1;                       /* clear EINT0 flag */
+  TRACE(TRC_ISR, 14, 0);
+  isr_evt_set(EVT_PROF, t_display);
+  VICVectAddr = 0;
+}
+
+void button_init(void) {
+  PINSEL4      = (PINSEL4 & ~(3 << 20)) | (1 << 20);
+  EXTMODE     |= 1;                 /* edge sensitive */
+  EXTPOLAR    &= ~1;                /* falling edge */
+  EXTINT       = 1;
+  VICVectAddr14 = (U32)button_irq;
+  VICVectCntl14 = 15;
+  VICIntEnable  = (1 << 14);
+}
+
+/* ---------------- Tasks ------------------- */
+
+/* Display Task – shows sensor readings on LCD
+   Each EVT_PROF shows the next page until the next update: one page per
+   registered task (peak/size of its stack on line 1, its profiler line
+   on line 2), then the 10 minute min/avg/max history, then the latency
+   pages (worst response [us] and deadline misses per task, worst
+   motion-to-LED latency). Lines go to the LCD server (Screen.c).
+   The status line is fan icon, temperature and its bar, bulb icon,
+   light and its bar, and '*' while motion is seen.
+*/
+#define BAR_CELLS         4
+#define PAGE_HIST         (os_tsk_info_cnt)
+#define PAGE_LAT          (os_tsk_info_cnt + 1)
+#define PAGE_LAT2         (os_tsk_info_cnt + 2)
+#define PAGE_CNT          (os_tsk_info_cnt + 3)
+
+/* Draw page 'page' into line1/line2; returns 0 for an unused task id */
+static int page_format(U32 page, char *line1, char *line2) {
+  HIST_STAT st;
+
+  if (page == PAGE_HIST) {
+    hist_query(HIST_TEMP, HIST_WIN, &st);
+    sprintf(line1, "T10m %3u/%3u/%3u", st.min, st.avg, st.max);
+    hist_query(HIST_LIGHT, HIST_WIN, &st);
+    sprintf(line2, "L10m %3u/%3u/%3u", st.min, st.avg, st.max);
+  } else if (page == PAGE_LAT) {
+    lat_format(&lat_temp, "temp", line1);
+    lat_format(&lat_light, "lght", line2);
+  } else if (page == PAGE_LAT2) {
+    lat_format(&lat_display, "disp", line1);
+    sprintf(line2, "mot>led%7u", lat_motion.max);
+  } else {
+    if (!prof_format(page, line2)) return 0;
+    sprintf(line1, "%-7.7s %3u/%-3u", tsk_info(page)->name,
+            tsk_stack_used(page), tsk_info(page)->stk_size);
+  }
+  return 1;
+}
+
+__task void display_task(void) {
+  char line[40];
+  char line2[40];
+  SENS_SNAP snap;
+  U32 page = 0;
+  U32 n;
+  char *p;
+  int job;
+
+  for (;;) {
+    hb_park();
+    os_evt_wait_or(EVT_TEMP_UPDATE | EVT_LIGHT_UPDATE | EVT_MOTION |
+                   EVT_PROF, 200);
+    hb_beat();
+    if (os_evt_get() & EVT_PROF) {
+      for (n = 0; n < PAGE_CNT; n++) {
+        if (++page >= PAGE_CNT) page = 1;
+        if (page_format(page, line, line2)) break;
+      }
+      if (n < PAGE_CNT) {
+        scr_line(1, line);
+        scr_line(2, line2);
+      }
+      continue;
+    }
+
+    /* a posted update is a job; released when it was first posted */
+    tsk_lock();
+    job = disp_pend;
+    if (job) lat_release(&lat_display, disp_rel);
+    disp_pend = 0;
+    tsk_unlock();
+    if (job) lat_start(&lat_display);
+
+    sens_snapshot(&snap);
+
+    p = line + sprintf(line, SCR_FAN "%2u", snap.val[SENS_TEMP]);
+    p = scr_bar(p, snap.val[SENS_TEMP], TEMP_SCALE, BAR_CELLS);
+    p += sprintf(p, SCR_BULB "%3u", snap.val[SENS_LIGHT]);
+    p = scr_bar(p, snap.val[SENS_LIGHT], LIGHT_SCALE, BAR_CELLS);
+    strcpy(p, snap.val[SENS_MOTION] ? "*" : " ");
+    scr_line(1, line);
+    if (job) lat_done(&lat_display);
+  }
+}
+
+/* Logger Task – prints last system log
+   Every record also goes to the flash log (Flog.c). The flash is
+   programmed from here, never from a sensor job: when a page is full,
+   when the open page times out, and at once for an overheat or stall
+   record. The flash log calls hold flog_res, never across the wait
+   or the LCD post.
+   Without LOG_TEXT (Config.h) records only go to flash.
+*/
+__task void logger_task(void) {
+  LOG_MSG *msg;
+#if (LOG_TEXT)
+  char text[4 + LOG_TEXT_LEN];
+#endif
+  int urgent;
+
+  res_lock(&flog_res);
+  flog_init(hb_cause());             /* may erase: IAP runs on this stack */
+  res_unlock(&flog_res);
+  for (;;) {
+    hb_park();
+    msg = log_wait(flog_left());
+    hb_beat();
+    res_lock(&flog_res);
+    if (msg == NULL) {
+      flog_flush();
+      res_unlock(&flog_res);
+      continue;
+    }
+    urgent = (msg->id == LOG_ID_OVERHEAT || msg->id == LOG_ID_STALL);
+    flog_add(msg);
+    if (urgent) flog_flush();
+    res_unlock(&flog_res);
+#if (LOG_TEXT)
+    strcpy(text, "Log:");
+    log_format(msg, text + 4);
+    scr_line(2, text);
+#endif
+    log_free(msg);
+  }
+}
+
+/* Emergency Task – flashes the LEDs while overheating
+   Sleeps until the overheat rule sees the temperature cross
+   OVERHEAT_TEMP (EVT_OVERHEAT), then flashes until it falls back
+   (EVT_COOLED). The same crossings log both edges, and so keep them in
+   flash, and put up and take down the LCD banner (rule_tab).
+*/
+__task void emergency_task(void) {
+  for (;;) {
+    hb_park();
+    os_evt_wait_or(EVT_OVERHEAT, 0xffff);
+    hb_beat();
+    emergency_flag = 1;
+
+    /* the flash owns all LEDs until released */
+    while (sens_read(SENS_TEMP) > OVERHEAT_TEMP) {
+      out_set(OUT_EMERG, OUT_PINS, OUT_PINS);
+      os_evt_wait_or(EVT_COOLED, 10);
+      out_set(OUT_EMERG, OUT_PINS, 0);
+      if (os_evt_wait_or(EVT_COOLED, 60) == OS_R_EVT) break;
+      hb_beat();
+    }
+    out_release(OUT_EMERG);
+    os_evt_clr(EVT_COOLED, os_tsk_self());
+    emergency_flag = 0;
+  }
+}
+
+/* Serial Task – commands on UART0
+   'T' binary trace dump, 'R' clear the trace, 'H' 10 minute history,
+   'P' the flash log as text, each record after its ticks since boot
+   (src id val0 val1 without LOG_TEXT).
+   Woken by the UART receive interrupt (EVT_SERIAL). Output is queued to
+   the TX ring, so the link runs at full rate without holding the CPU.
+   Also owns the telemetry stream: every EVT_TELEM adds a sensor snapshot
+   to the open frame, which is flushed when full or after TELEM_FLUSH.
+*/
+__task void serial_task(void) {
+  HIST_STAT st;
+  SENS_SNAP snap;
+  LOG_MSG rec;
+#if (LOG_TEXT)
+  char text[LOG_TEXT_LEN];
+#endif
+  U32 pos, t;
+  U16 flags;
+  int c, more;
+
+  for (;;) {
+    hb_park();
+    if (os_evt_wait_or(EVT_SERIAL | EVT_TELEM, telem_left()) == OS_R_TMO) {
+      hb_beat();
+      telem_flush();
+      continue;
+    }
+    hb_beat();
+    flags = os_evt_get();
+    if (flags & EVT_TELEM) {
+      sens_snapshot(&snap);
+      telem_add(&snap);
+    }
+    while ((c = ser_getc()) >= 0) {
+      switch (c) {
+        case 'T':
+          telem_flush();
+          trace_dump();
+          break;
+        case 'R':
+          trace_reset();
+          break;
+        case 'H':
+          hist_query(HIST_TEMP, HIST_WIN, &st);
+          printf("temp  %3u %3u %3u\r\n", st.min, st.avg, st.max);
+          hist_query(HIST_LIGHT, HIST_WIN, &st);
+          printf("light %3u %3u %3u\r\n", st.min, st.avg, st.max);
+          break;
+        case 'P':
+          pos = 0;
+          for (;;) {
+            res_lock(&flog_res);    /* one record at a time */
+            more = flog_read(&pos, &rec, &t);
+            res_unlock(&flog_res);
+            if (!more) break;
+            hb_beat();              /* the whole log takes seconds */
+#if (LOG_TEXT)
+            log_format(&rec, text);
+            printf("%8u %s\r\n", t, text);
+#else
+            printf("%8u %u %u %u %u\r\n", t, rec.src, rec.id,
+                   rec.val[0], rec.val[1]);
+#endif
+          }
+          break;
+      }
+    }
+  }
+}
+
+/* Init Task */
+__task void init(void) {
+  U32 prio;
+
+  PINSEL10 = 0;
+  out_init();
+
+  sens_init();
+  hist_init(HIST_TEMP, 1);
+  hist_init(HIST_LIGHT, 4);
+  log_init();
+
+  clk_init();
+  init_serial();
+  prof_init();
+  wheel_init();
+
+  LCD_init();
+  LCD_cur_off();
+  LCD_cls();
+  LCD_puts((U8*)"Smart Home System");
+  LCD_flush();
+
+  /* Create tasks. init runs above all of them so that every task id is
+     valid and registered before any task runs. OS_TASKCNT includes init
+     itself. */
+  os_tsk_prio_self(PRIO_INIT);
+  sched_start(task_tab, sizeof(task_tab) / sizeof(task_tab[0]));
+  prio = tsk_info(t_logger)->base_prio;
+  if (tsk_info(t_serial)->base_prio > prio) prio = tsk_info(t_serial)->base_prio;
+  res_init(&flog_res, "flog", RES_ICPP, prio);
+  lat_task_init(&lat_display, t_display);
+  wheel_tmr_init(&beat_tmr, beat_on, NULL);
+  wheel_tmr_init(&beat_off_tmr, beat_off, NULL);
+  wheel_start(&beat_tmr, CLOCK_PERIOD, CLOCK_PERIOD);
+  stab_start(sens_tab, sens_run, SENS_ROWS);
+
+  hb_init();
+  hb_watch(t_sensor0,   HB_BUDGET, 1);
+  hb_watch(t_sensor1,   HB_BUDGET, 1);
+  hb_watch(t_display,   HB_BUDGET, 1);
+  hb_watch(t_logger,    HB_BUDGET, 1);
+  hb_watch(t_emergency, HB_BUDGET, 1);
+  hb_watch(t_lcd,       HB_BUDGET_LCD, 1);
+  hb_watch(t_serial,    HB_BUDGET_SERIAL, 0);
+
+  rule_start(rule_tab, rule_run, RULE_ROWS);
+  button_init();
+  ser_attach(t_serial, EVT_SERIAL);
+#if (SENSOR_ADC)
+  adc_attach(t_sensor0, STAB_EVT_ADC);
+  adc_init();
+#endif
+
+  os_tsk_delete_self();
+}
+
+/* Main */
+int main(void) {
+  os_sys_init(init);
+}
@@ -0,0 +1,172 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Priority ceiling resource manager
+ *
+ *  Kernel-backed ICPP and OCPP on top of RTX task priorities.
+ *
+ *  - ICPP: res_lock() raises the caller to the resource ceiling with
+ *    os_tsk_prio_self() before entering, so no other user of the resource
+ *    can preempt it and the critical section runs in one piece.
+ *  - OCPP: the caller keeps its priority. It may enter only if its priority
+ *    is above the ceilings of all resources held by other tasks (the system
+ *    ceiling); otherwise it blocks and the task holding the ceiling resource
+ *    inherits its priority until it releases.
+ *
+ *  Blocked tasks wait on EVT_RES with no timeout and are woken by
+ *  res_unlock(), so there is no polling. Manager state is only touched with
+ *  the task switch locked (tsk_lock), which is held for a few instructions
+ *  and never across a call that could block. With either protocol a task
+ *  is blocked by lower priority work for at most one critical section.
+ *
+ *  A task must be in the task registry (tsk_register) before it locks a
+ *  resource; its current priority is kept there, with a stack of the
+ *  resources it holds and the priority it had before each one. Releasing
+ *  the newest drops back to that priority; releasing an older one first
+ *  hands its saved priority to the resource locked after it, so the
+ *  caller keeps the ceiling (and any inheritance) of what it still holds
+ *  and returns to its original priority with the last release. A task
+ *  holds at most RES_NEST (TaskReg.h) resources at once and never locks
+ *  one it holds already; res_lock() stops in os_error() otherwise.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "Ceiling.h"
+#include "TaskReg.h"
+#include "Trace.h"
+
+extern void os_error (U32 err_code);   /* RTX_Config.c */
+
+static RES *res_list;               /* all initialised resources */
+static U32  res_nwait;              /* tasks blocked in res_lock */
+
+/* Set the caller's priority and remember it in the registry */
+static void set_prio_self(TSK_INFO *t, U32 prio) {
+  if (prio == t->prio) return;
+  t->prio = (U8)prio;
+  os_tsk_prio_self((U8)prio);
+}
+
+/* Highest ceiling of resources held by tasks other than 'self' (OCPP
+   system ceiling). The holder of that resource is returned in *holder. */
+static U32 system_ceiling(OS_TID self, OS_TID *holder) {
+  RES *q;
+  U32 sc = 0;
+
+  for (q = res_list; q != NULL; q = q->link) {
+    if (q->owner != 0 && q->owner != self && q->ceiling > sc) {
+      sc = q->ceiling;
+      *holder = q->owner;
+    }
+  }
+  return sc;
+}
+
+/* Initialise a resource with its protocol and static ceiling */
+void res_init(RES *r, const char *name, U32 protocol, U32 ceiling) {
+  r->name      = name;
+  r->protocol  = (U8)protocol;
+  r->ceiling   = (U8)ceiling;
+  r->owner     = 0;
+  tsk_lock();
+  r->link      = res_list;
+  res_list     = r;
+  tsk_unlock();
+}
+
+/* Lock a resource, blocking on the kernel until it is granted */
+void res_lock(RES *r) {
+  OS_TID self = os_tsk_self();
+  TSK_INFO *t = tsk_info(self);
+  TSK_INFO *h;
+  OS_TID holder;
+  U32 prio, prev;
+
+  prev = t->prio;
+  if (r->protocol == RES_ICPP && r->ceiling > prev) {
+    set_prio_self(t, r->ceiling);
+  }
+  prio = t->prio;
+
+  for (;;) {
+    holder = 0;
+    tsk_lock();
+    if (r->owner == self || t->ceilings == RES_NEST) {
+      tsk_unlock();
+      os_error(r->owner == self ? RES_ERR_OWNER : RES_ERR_NEST);
+    }
+    if (r->owner == 0 &&
+        (r->protocol == RES_ICPP || prio > system_ceiling(self, &holder))) {
+      r->owner = self;
+      t->res_held[t->ceilings] = r;
+      t->res_prio[t->ceilings] = (U8)prev;
+      t->ceilings++;
+      t->res_locks++;
+      tsk_unlock();
+      TRACE(TRC_RES_LOCK, self, r->ceiling);
+      return;
+    }
+    if (r->owner != 0 && r->owner != self) holder = r->owner;
+    t->waiting = 1;
+    t->res_blocks++;
+    res_nwait++;
+    /* OCPP priority inheritance: raising the holder to our own level
+       cannot preempt us, so it is safe with the switch locked. */
+    h = tsk_info(holder);
+    if (holder != 0 && h != NULL && h->prio < prio) {
+      h->prio = (U8)prio;
+      os_tsk_prio(holder, (U8)prio);
+    }
+    tsk_unlock();
+    TRACE(TRC_RES_BLOCK, self, holder);
+    os_evt_wait_or(EVT_RES, 0xffff);
+  }
+}
+
+/* Release a resource, wake blocked tasks and drop back to the priority
+   the caller had before the lock */
+void res_unlock(RES *r) {
+  OS_TID self = os_tsk_self();
+  TSK_INFO *t = tsk_info(self);
+  TSK_INFO *w;
+  U32 d, top, prio, wake, tid;
+
+  tsk_lock();
+  for (d = t->ceilings; d > 0 && t->res_held[d - 1] != r; d--);
+  if (d-- == 0) {                   /* not held by the caller */
+    tsk_unlock();
+    return;
+  }
+  r->owner = 0;
+  prio = t->res_prio[d];
+  top  = (d == t->ceilings - 1u);
+  if (!top) t->res_prio[d + 1] = (U8)prio;
+  t->ceilings--;
+  for (; d < t->ceilings; d++) {
+    t->res_held[d] = t->res_held[d + 1];
+    t->res_prio[d] = t->res_prio[d + 1];
+  }
+
+  /* collect every blocked task, each one re-checks its own resource.
+     The flags are cleared here so that a task blocking from now on is
+     not missed; task ids fit the mask (OS_TASKCNT < 32). */
+  wake = 0;
+  for (tid = 1; res_nwait != 0 && tid < os_tsk_info_cnt; tid++) {
+    w = &os_tsk_info[tid];
+    if (w->waiting) {
+      w->waiting = 0;
+      res_nwait--;
+      wake |= 1u << tid;
+    }
+  }
+  tsk_unlock();
+  TRACE(TRC_RES_UNLOCK, self, r->ceiling);
+
+  for (tid = 1; wake != 0; tid++) {
+    if (wake & (1u << tid)) {
+      wake &= ~(1u << tid);
+      os_evt_set(EVT_RES, tid);
+    }
+  }
+  /* the newest resource also drops any priority inherited while it was
+     held; an older one leaves the caller at the level of the rest */
+  if (top) set_prio_self(t, prio);
+}
@@ -0,0 +1,37 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Priority ceiling resource manager definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __CEILING_H
+#define __CEILING_H
+
+/* Protocols */
+#define RES_ICPP        0           /* Immediate ceiling priority protocol */
+#define RES_OCPP        1           /* Original ceiling priority protocol  */
+
+/* Event flag used to wake tasks blocked in res_lock(); reserved for the
+   manager, application events must not use it. */
+#define EVT_RES         0x8000
+
+/* A protected resource. The ceiling is the highest RTX priority (larger
+   number = higher priority) of any task that locks the resource; it is
+   fixed when the resource is initialised. */
+typedef struct res {
+  const char *name;
+  U8          protocol;             /* RES_ICPP / RES_OCPP */
+  U8          ceiling;
+  OS_TID      owner;                /* 0 = free */
+  struct res *link;                 /* list of all resources */
+} RES;
+
+/* os_error() codes of the manager. A task holds at most RES_NEST
+   (TaskReg.h) resources at once and must not lock one it already holds;
+   either is a design error and stops the system (RTX_Config.c). */
+#define RES_ERR_NEST    0x10        /* RES_NEST resources held already */
+#define RES_ERR_OWNER   0x11        /* resource held by the caller */
+
+extern void res_init (RES *r, const char *name, U32 protocol, U32 ceiling);
+extern void res_lock (RES *r);
+extern void res_unlock (RES *r);
+
+#endif
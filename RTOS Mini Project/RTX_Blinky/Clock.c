@@ -0,0 +1,45 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Free-running timestamp clock
+ *
+ *  Timer 1 runs free at CLK_HZ for sub-tick timestamps. Its match
+ *  registers stay available for timed interrupts; users set MCR bits
+ *  without a counter reset. The timer has one VIC channel, so the
+ *  interrupt is owned here and passed on per match flag: MR0 is the
+ *  profiler (Profile.c), MR1 the timer wheel (Wheel.c).
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Clock.h"
+
+static CLK_MATCH clk_fn[4];         /* handler per match register */
+
+/* Timer 1 interrupt: every match flag set goes to its handler */
+static __irq void clk_irq(void) {
+  U32 ir = T1IR & 0x0F;
+  U32 i;
+
+  T1IR = ir;                        /* clear the flags taken */
+  for (i = 0; i < 4; i++) {
+    if ((ir & (1 << i)) && clk_fn[i] != NULL) clk_fn[i]();
+  }
+  VICVectAddr = 0;                  /* acknowledge interrupt */
+}
+
+/* Start Timer 1 free-running (call once from init) */
+void clk_init(void) {
+  PCONP |= (1 << 2);                /* power up Timer 1 */
+  T1TCR  = 2;                       /* stop and reset */
+  T1PR   = 0;
+  T1MCR  = 0;                       /* no match actions yet */
+  T1TCR  = 1;                       /* run */
+}
+
+/* Call fn on every match of MR0..MR3 ('mr'); the caller sets the match
+   register and its MCR interrupt bit. Call from init after clk_init. */
+void clk_attach(U32 mr, CLK_MATCH fn) {
+  clk_fn[mr]    = fn;
+  VICVectAddr5  = (U32)clk_irq;
+  VICVectCntl5  = 14;
+  VICIntEnable  = (1 << 5);
+}
@@ -0,0 +1,23 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Free-running timestamp clock definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __CLOCK_H
+#define __CLOCK_H
+
+/* Timer 1 counts at CLK_HZ and is never reset, so differences of two
+   clk_now() values are valid across wrap-around (every ~357 s). RTX owns
+   Timer 0, whose counter restarts every tick. */
+#define CLK_HZ          12000000    /* Timer 1 clock [Hz] */
+#define CLK_PER_US      (CLK_HZ / 1000000)
+#define CLK_PER_TICK    (CLK_HZ / 100)      /* RTX tick, OS_TICK = 10 ms */
+
+#define clk_now()       (T1TC)
+
+/* Match handler, called from the shared Timer 1 interrupt */
+typedef void (*CLK_MATCH)(void);
+
+extern void clk_init (void);
+extern void clk_attach (U32 mr, CLK_MATCH fn);
+
+#endif
@@ -0,0 +1,77 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Build configuration
+ *
+ *  Every compile-time switch of the application and the profile-dependent
+ *  ones of RTX_Config.c get their value here, from CFG_PROFILE. A build
+ *  profile is then one define in the uVision target (C/C++ tab, e.g.
+ *  CFG_PROFILE=1) instead of edits across the sources; any single value
+ *  can still be overridden with a define of its own name.
+ *
+ *    CFG_MINIMAL     smallest image: as production, with smaller log pools
+ *                    and history
+ *    CFG_PRODUCTION  no stack check, trace, profiler or text log, and no
+ *                    round-robin
+ *    CFG_DEBUG       all instrumentation and a watchdog that does not
+ *                    reset (the default)
+ *
+ *  Included by the headers and by RTX_Config.c that take these values.
+ *----------------------------------------------------------------------------*/
+
+#ifndef __CONFIG_H
+#define __CONFIG_H
+
+#define CFG_MINIMAL     0
+#define CFG_PRODUCTION  1
+#define CFG_DEBUG       2
+
+#ifndef CFG_PROFILE
+#define CFG_PROFILE     CFG_DEBUG
+#endif
+
+#if   (CFG_PROFILE == CFG_DEBUG)
+#define CFG_INSTR       1
+#elif (CFG_PROFILE == CFG_PRODUCTION || CFG_PROFILE == CFG_MINIMAL)
+#define CFG_INSTR       0
+#else
+#error CFG_PROFILE invalid
+#endif
+
+/* RTX kernel (RTX_Config.c). The tick stays at 10 ms in every profile:
+   all periods and timeouts are counted in ticks, and tickless idle
+   already skips the ticks nothing waits for. */
+#ifndef OS_STKCHECK
+#define OS_STKCHECK     CFG_INSTR   /* check the stack on every switch */
+#endif
+#ifndef OS_ROBIN
+#define OS_ROBIN        CFG_INSTR   /* priorities are unique: no effect */
+#endif
+
+/* Instrumentation */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE    CFG_INSTR   /* binary trace, 'T'/'R' (Trace.c) */
+#endif
+#ifndef PROF_ENABLE
+#define PROF_ENABLE     CFG_INSTR   /* profiler sampling interrupt, 2 kHz
+                                       while a task runs; off in idle */
+#endif
+#ifndef LOG_TEXT
+#define LOG_TEXT        CFG_INSTR   /* log records as text on the LCD and
+                                       in 'P'; raw values otherwise */
+#endif
+
+/* Watchdog (Health.c): reset on timeout, or only flag it so that a
+   debugger can halt the board */
+#ifndef WDT_RESET
+#define WDT_RESET       (CFG_PROFILE != CFG_DEBUG)
+#endif
+
+/* Sizes */
+#if (CFG_PROFILE == CFG_MINIMAL)
+#define CFG_LOG_SLOTS   2           /* log blocks per source */
+#define CFG_HIST_LEN    512         /* history samples per series, 17 min */
+#else
+#define CFG_LOG_SLOTS   3
+#define CFG_HIST_LEN    1024
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Fixed-point sensor filter
+ *
+ *  Sits between the ADC blocks and the sensor tasks. The decimator sums
+ *  'decim' raw samples and dumps the mean, the EMA smooths the decimated
+ *  stream and the level quantiser adds hysteresis around each threshold,
+ *  so a value hovering on a boundary does not toggle the level. Tasks act
+ *  (LEDs, log, display) only when lvl_update() reports a change.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "Filter.h"
+
+/* Feed n samples taken every 'stride' entries from x. Returns 1 if at
+   least one new output was produced (read it with filt_value). */
+int filt_input(FILTER *f, const U16 *x, U32 stride, U32 n) {
+  int out = 0;
+  S32 mean;
+
+  while (n--) {
+    f->acc += *x;
+    x += stride;
+    if (++f->cnt < f->decim) continue;
+
+    mean   = (S32)((f->acc << 8) / f->cnt);
+    f->acc = 0;
+    f->cnt = 0;
+    if (!f->primed || f->shift == 0) {
+      f->ema    = mean;
+      f->primed = 1;
+    } else {
+      f->ema += (mean - f->ema) >> f->shift;
+    }
+    out = 1;
+  }
+  return out;
+}
+
+/* Current filter output, in input units (rounded) */
+U32 filt_value(const FILTER *f) {
+  return (U32)(f->ema + 0x80) >> 8;
+}
+
+/* Quantise a value; returns 1 if the level changed */
+int lvl_update(LEVELS *l, U32 value) {
+  U32 k;
+
+  if (l->level == LVL_NONE) {
+    for (k = 0; k < l->nthr && value >= l->thr[k]; k++);
+    l->level = (U8)k;
+    return 1;
+  }
+  k = l->level;
+  while (k < l->nthr && value >= l->thr[k]) k++;
+  if (k == l->level) {
+    while (k > 0 && value + l->hyst < l->thr[k - 1]) k--;
+  }
+  if (k == l->level) return 0;
+  l->level = (U8)k;
+  return 1;
+}
@@ -0,0 +1,38 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Fixed-point sensor filter definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __FILTER_H
+#define __FILTER_H
+
+/* Boxcar decimator (first-order CIC) followed by an exponential moving
+   average with alpha = 1/2^shift. All state is integer. */
+typedef struct {
+  U16 decim;                        /* input samples per output */
+  U8  shift;                        /* EMA: 0 = off, n = alpha 1/2^n */
+  U8  primed;                       /* EMA seeded by the first output */
+  U16 cnt;                          /* samples summed so far */
+  U32 acc;                          /* boxcar sum */
+  S32 ema;                          /* EMA state, Q8 */
+} FILTER;
+
+#define FILT_INIT(decim, shift)   { (decim), (shift), 0, 0, 0, 0 }
+
+/* Level quantiser with hysteresis. thr[] holds nthr ascending thresholds
+   giving levels 0..nthr. A level is entered upwards at thr[k] and left
+   downwards only below thr[k] - hyst. */
+typedef struct {
+  const U16 *thr;
+  U8  nthr;
+  U8  hyst;
+  U8  level;                        /* LVL_NONE until the first value */
+} LEVELS;
+
+#define LVL_NONE                  0xFF
+#define LVL_INIT(thr, hyst)       { (thr), sizeof(thr)/sizeof((thr)[0]), (hyst), LVL_NONE }
+
+extern int filt_input (FILTER *f, const U16 *x, U32 stride, U32 n);
+extern U32 filt_value (const FILTER *f);
+extern int lvl_update (LEVELS *l, U32 value);
+
+#endif
@@ -0,0 +1,302 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Persistent flash log
+ *
+ *  Keeps the log records across resets in the last four 4 KB sectors of
+ *  the internal flash, written through the IAP routines of the boot ROM.
+ *  The log is append-only: records collect in a RAM page and are
+ *  programmed a whole page at a time, when it is full, FLOG_FLUSH ticks
+ *  after its first record, or at once for an urgent one (flog_flush()).
+ *  Each page carries a 32-bit time mark that dates its 16-bit record
+ *  times (Flog.h).
+ *  A page is programmed only once (the flash keeps ECC per 16 bytes), so
+ *  a page flushed early is padded with erased slots.
+ *
+ *  The sectors are used in turn: when one is full the next is erased and
+ *  becomes the segment being written, dropping the oldest records. Every
+ *  sector is erased once per FLOG_SEGS fills; at 100000 rated cycles
+ *  that is 6 million records even if every page holds only one. The
+ *  boot scan reads the segment headers, then the first slot of each page
+ *  of the newest segment to find where to continue; a reset between an
+ *  erase and the first page program leaves a segment without header,
+ *  which is erased again.
+ *
+ *  Only the logger calls flog_add()/flog_flush(), so programming and
+ *  erasing never run on a sensor task. flog_read() may run on another
+ *  task; the application serialises it with the writer (flog_res,
+ *  Blinky.c). The flash cannot be read while it is being programmed and
+ *  the vectors and handlers are in it, so each IAP call runs with every
+ *  VIC source masked (vic_lock(), Vic.c): about 1 ms per page and about
+ *  100 ms per erase (once per 4 KB of log). A source keeps one request
+ *  pending at most, so what comes in meanwhile is not just delayed:
+ *  - the RTX tick is stretched over the call and the kernel advanced by
+ *    the ticks counted from its timer afterwards (os_tick_hold(),
+ *    RTX_Config.c), so kernel time, timeouts and the heartbeat ages keep
+ *    up with the clock;
+ *  - an erase drops the ADC scans of that time, about 9 (Timer 3 keeps
+ *    one match pending), so that block ends 0.1 s late, and any UART0
+ *    bytes received past its 16-byte FIFO (1.4 ms at 115200 Baud). A
+ *    page program, 1 ms, loses at most one scan.
+ *  IAP also uses the top 32 bytes of the on-chip RAM, kept out of the
+ *  linker's IRAM region in Blinky.uvproj together with the sectors.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include <string.h>
+#include "Vic.h"
+#include "Log.h"
+#include "Flog.h"
+
+#define FLOG_SEC0       24          /* first sector */
+#ifndef FLOG_BASE
+#define FLOG_BASE       0x0007A000  /* address of sector 24 */
+#endif
+#ifndef IAP_ENTRY
+#define IAP_ENTRY       0x7FFFFFF1  /* boot ROM, Thumb */
+#endif
+#define FLOG_SEG        4096        /* sector size */
+#define FLOG_RECS       (FLOG_PAGE / sizeof(LOG_MSG))
+#define FLOG_PAGES      (FLOG_SEG / FLOG_PAGE)
+#define FLOG_SLOTS      (FLOG_SEG / sizeof(LOG_MSG))
+#define FLOG_MAGIC      0x474F4C46  /* "FLOG" */
+#define FLOG_BLANK      0xFF        /* src of an erased slot */
+#define CCLK_KHZ        48000       /* LPC2300.s: PLL 192 MHz / 4 */
+
+#define IAP_PREPARE     50
+#define IAP_COPY        51
+#define IAP_ERASE       52
+#define IAP_OK          0
+
+/* Tick stretch over an IAP call, RTX_Config.c */
+extern void os_tick_hold (void);
+extern U32  os_tick_release (void);
+
+#define SEG_HDR(s)      ((const FLOG_HDR *)(FLOG_BASE + (s) * FLOG_SEG))
+#define SEG_REC(s)      ((const LOG_MSG *)(FLOG_BASE + (s) * FLOG_SEG))
+
+typedef void (*IAP_FN)(U32 *cmd, U32 *res);
+
+typedef struct {
+  U32 magic;
+  U16 seq;
+  U16 boot;
+} FLOG_HDR;
+
+static U32 flog_buf[FLOG_PAGE / 4]; /* page being filled, word aligned */
+static U32 flog_fill;               /* slots used in flog_buf */
+static U32 flog_skip;               /* of those, header and time mark */
+static U32 flog_time;               /* os_time_get() extended to 32 bits */
+static U32 flog_seg;                /* segment being written */
+static U32 flog_pg;                 /* its next page to program */
+static U16 flog_seq;
+static U16 flog_boot;
+static U16 flog_first;              /* os_time_get() of the first record */
+static U8  flog_ok;                 /* 0 after an erase failed */
+static U32 flog_nerr;
+
+/* Prepare sector 'sec' and run command c[] with all interrupts masked.
+   The kernel is suspended over the call and advanced afterwards by the
+   ticks it missed, so kernel time does not fall behind. */
+static U32 flog_iap(U32 sec, U32 *c) {
+  IAP_FN iap = (IAP_FN)IAP_ENTRY;
+  U32 p[3], r[3], was, lost;
+
+  p[0] = IAP_PREPARE;
+  p[1] = sec;
+  p[2] = sec;
+  os_suspend();
+  was = vic_lock(VIC_ALL);
+  os_tick_hold();
+  iap(p, r);
+  if (r[0] == IAP_OK) iap(c, r);
+  lost = os_tick_release();
+  vic_unlock(was);
+  os_resume(lost);
+  return r[0];
+}
+
+/* Records in flog_buf, not counting the header and the time mark */
+static U32 flog_recs(void) {
+  return flog_fill - flog_skip;
+}
+
+/* Ticks since boot. The logger calls flog_left() at least every
+   FLOG_FLUSH ticks, which keeps this ahead of the 16-bit wrap. */
+static U32 flog_ticks(void) {
+  flog_time += (U16)(os_time_get() - (U16)flog_time);
+  return flog_time;
+}
+
+/* Erase the next segment and start its first page with the header */
+static void flog_open(void) {
+  FLOG_HDR *h = (FLOG_HDR *)flog_buf;
+  U32 s = (flog_seg + 1) % FLOG_SEGS;
+  U32 c[4];
+
+  c[0] = IAP_ERASE;
+  c[1] = FLOG_SEC0 + s;
+  c[2] = FLOG_SEC0 + s;
+  c[3] = CCLK_KHZ;
+  if (flog_iap(FLOG_SEC0 + s, c) != IAP_OK) {
+    flog_nerr++;
+    flog_ok = 0;
+    return;
+  }
+  flog_seg  = s;
+  flog_pg   = 0;
+  flog_seq++;
+  h->magic  = FLOG_MAGIC;
+  h->seq    = flog_seq;
+  h->boot   = flog_boot;
+  flog_fill = 1;
+  flog_skip = 1;
+}
+
+/* Program flog_buf, padded to a page, then move on to the next page */
+static void flog_program(void) {
+  U32 dst = FLOG_BASE + flog_seg * FLOG_SEG + flog_pg * FLOG_PAGE;
+  U32 c[5];
+
+  memset((U8 *)flog_buf + flog_fill * sizeof(LOG_MSG), FLOG_BLANK,
+         FLOG_PAGE - flog_fill * sizeof(LOG_MSG));
+  c[0] = IAP_COPY;
+  c[1] = dst;
+  c[2] = (U32)flog_buf;
+  c[3] = FLOG_PAGE;
+  c[4] = CCLK_KHZ;
+  if (flog_iap(FLOG_SEC0 + flog_seg, c) != IAP_OK ||
+      memcmp((const void *)dst, flog_buf, FLOG_PAGE) != 0) {
+    flog_nerr++;                    /* page lost, carry on with the next */
+  }
+  flog_fill = 0;
+  flog_skip = 0;
+  if (++flog_pg == FLOG_PAGES) flog_open();
+}
+
+/* Find the segment being written and its next free page, and log the
+   boot with the reset source 'cause' (RSIR bits). Called by the logger
+   before its first record: it may erase. */
+void flog_init(U32 cause) {
+  const FLOG_HDR *h;
+  const LOG_MSG *rec;
+  LOG_MSG boot;
+  U32 s, i;
+  int found = 0;
+
+  flog_ok   = 1;
+  flog_fill = 0;
+  flog_skip = 0;
+  for (s = 0; s < FLOG_SEGS; s++) {
+    h = SEG_HDR(s);
+    if (h->magic != FLOG_MAGIC) continue;
+    if (!found || (S16)(h->seq - flog_seq) > 0) {
+      flog_seg = s;
+      flog_seq = h->seq;
+      found    = 1;
+    }
+  }
+
+  if (!found) {
+    flog_seg  = FLOG_SEGS - 1;      /* the first segment opened is 0 */
+    flog_seq  = 0;
+    flog_boot = 0;
+    flog_pg   = FLOG_PAGES;
+  } else {
+    /* a programmed page always starts with a record */
+    rec = SEG_REC(flog_seg);
+    for (flog_pg = 1; flog_pg < FLOG_PAGES; flog_pg++) {
+      if (rec[flog_pg * FLOG_RECS].src == FLOG_BLANK) break;
+    }
+    flog_boot = SEG_HDR(flog_seg)->boot;
+    for (i = 1; i < flog_pg * FLOG_RECS; i++) {
+      if (rec[i].src != FLOG_BLANK && rec[i].id == LOG_ID_BOOT &&
+          (S16)(rec[i].val[0] - flog_boot) > 0) {
+        flog_boot = rec[i].val[0];
+      }
+    }
+  }
+  flog_boot++;
+  if (flog_pg == FLOG_PAGES) flog_open();
+
+  boot.src    = LOG_SRC_SYS;
+  boot.id     = LOG_ID_BOOT;
+  boot.time   = os_time_get();
+  boot.val[0] = flog_boot;
+  boot.val[1] = (U16)cause;
+  flog_add(&boot);
+}
+
+/* Append a copy of a record (logger side); the first one of a page
+   goes after the page's time mark */
+void flog_add(const LOG_MSG *msg) {
+  LOG_MSG *mark;
+  U32 t;
+
+  if (!flog_ok) return;
+  if (flog_recs() == 0) {
+    t          = flog_ticks();
+    flog_first = (U16)t;
+    mark         = (LOG_MSG *)flog_buf + flog_fill++;
+    mark->src    = LOG_SRC_SYS;
+    mark->id     = LOG_ID_TIME;
+    mark->time   = (U16)t;
+    mark->val[0] = (U16)t;
+    mark->val[1] = (U16)(t >> 16);
+    flog_skip    = flog_fill;
+  }
+  ((LOG_MSG *)flog_buf)[flog_fill++] = *msg;
+  if (flog_fill == FLOG_RECS) flog_program();
+}
+
+/* Program the open page now, if it holds any record */
+void flog_flush(void) {
+  if (flog_ok && flog_recs() > 0) flog_program();
+}
+
+/* Ticks until the open page is due, FLOG_FLUSH if it holds no record:
+   the logger waits at most this long, so call it on every wakeup */
+U16 flog_left(void) {
+  S32 d;
+
+  flog_ticks();
+  if (!flog_ok || flog_recs() == 0) return FLOG_FLUSH;
+  d = FLOG_FLUSH - (S32)(U16)(os_time_get() - flog_first);
+  return (d > 0) ? (U16)d : 0;
+}
+
+/* Programmed records, oldest first, with their time in ticks since
+   boot: start with *pos = 0, returns 0 after the last one. Records still
+   in the RAM page are not seen. */
+int flog_read(U32 *pos, LOG_MSG *msg, U32 *time) {
+  const LOG_MSG *rec, *mark;
+  U32 k, s, i, base;
+
+  while (*pos < FLOG_SEGS * FLOG_SLOTS) {
+    k = *pos / FLOG_SLOTS;
+    i = *pos % FLOG_SLOTS;
+    s = (flog_seg + 1 + k) % FLOG_SEGS;
+    if (SEG_HDR(s)->magic != FLOG_MAGIC) {
+      *pos = (k + 1) * FLOG_SLOTS;  /* erased: skip the segment */
+      continue;
+    }
+    (*pos)++;
+    rec = SEG_REC(s) + i;
+    if (i == 0 || rec->src == FLOG_BLANK || rec->id == LOG_ID_TIME) continue;
+    *msg = *rec;
+
+    /* the mark is the first slot of the page, after the header in page 0 */
+    mark  = SEG_REC(s) + (i - i % FLOG_RECS) + (i < FLOG_RECS);
+    *time = rec->time;
+    if (mark->id == LOG_ID_TIME) {
+      base  = mark->val[0] | (U32)mark->val[1] << 16;
+      *time = base + (S16)(U16)(rec->time - (U16)base);
+    }
+    return 1;
+  }
+  return 0;
+}
+
+/* Failed page programs and erases since reset */
+U32 flog_errors(void) {
+  return flog_nerr;
+}
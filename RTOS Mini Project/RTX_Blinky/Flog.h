@@ -0,0 +1,37 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Persistent flash log definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __FLOG_H
+#define __FLOG_H
+
+#define FLOG_SEGS       4           /* 4 KB sectors 24..27, one segment each */
+#define FLOG_PAGE       256         /* bytes per program, the IAP minimum */
+#define FLOG_FLUSH      30000       /* ticks from first record to program */
+
+/* Segment layout (records are LOG_MSG, 8 bytes):
+
+     slot 0             header: U32 magic, U16 seq, U16 boot
+     slot 1..511        records, programmed a page (32 slots) at a time
+
+   seq counts segment openings; the valid segment with the highest seq is
+   the one being written, the next one the oldest. boot is the boot count
+   when the segment was opened, every boot starts with a LOG_ID_BOOT
+   record that also holds the reset source. Slots of erased flash (src
+   0xFF) are padding.
+
+   The first record of every page (after the header in page 0) is a
+   LOG_ID_TIME mark: the time of the page's first record in ticks since
+   boot, 32 bits. A page is programmed at most FLOG_FLUSH ticks after
+   its first record, so the 16-bit times of its records are all within
+   +/-327 s of the mark and flog_read() extends them from it. Records
+   are ordered by boot, then by this time. */
+
+extern void flog_init (U32 cause);
+extern void flog_add (const LOG_MSG *msg);
+extern void flog_flush (void);
+extern U16  flog_left (void);
+extern int  flog_read (U32 *pos, LOG_MSG *msg, U32 *time);
+extern U32  flog_errors (void);
+
+#endif
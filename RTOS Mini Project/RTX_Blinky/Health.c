@@ -0,0 +1,140 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Health monitor
+ *
+ *  A watched task beats (hb_beat()) whenever it wakes and parks
+ *  (hb_park()) before its main wait. While it is not parked it has to
+ *  beat again within its budget; a task that does not is late: stuck in
+ *  a wait it should not be in, looping, or starved by the tasks above
+ *  it. hb_monitor() looks at every watched task each HB_PERIOD ticks,
+ *  logs the first look that finds one late (LOG_ID_STALL) and feeds the
+ *  watchdog only while no critical task is late. The monitor has the
+ *  lowest priority, so a CPU with no time left for it stops the feed too.
+ *
+ *  A stuck critical task is thus logged within its budget + HB_PERIOD
+ *  and resets the chip WDT_MS later; os_error() stops in a loop and ends
+ *  the same way. The reset source (RSIR) is read back at the next start
+ *  and goes into the boot record of the flash log. With WDT_RESET 0 (the
+ *  debug profile, Config.h) a timeout only sets WDTOF, so the board is
+ *  not reset while a debugger holds it.
+ *
+ *  The state is kept in the task registry. A task only writes its own
+ *  beat and park fields; the monitor reads the pair under tsk_lock().
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "TaskReg.h"
+#include "Log.h"
+#include "Trace.h"
+#include "Vic.h"
+#include "Health.h"
+
+#define WDEN            0x01        /* WDMOD: enable */
+#define WDRESET         0x02        /* WDMOD: reset on timeout */
+#define WDT_PER_MS      1000        /* 4 MHz IRC / 4 */
+
+static U32 hb_rsir;                 /* RSIR at start */
+static U32 hb_nover;
+static U32 hb_nfeed;
+
+/* Two-store feed sequence; an interrupt in between would abort it */
+static void hb_feed(void) {
+  U32 was;
+
+  was = vic_lock(VIC_ALL);
+  WDFEED = 0xAA;
+  WDFEED = 0x55;
+  vic_unlock(was);
+  hb_nfeed++;
+}
+
+/* Take the reset source and start the watchdog (call from init). Once
+   enabled it cannot be stopped: the first feed is due within WDT_MS. */
+void hb_init(void) {
+  hb_rsir  = RSIR & 0x0F;
+  RSIR     = 0x0F;                  /* write one to clear */
+  WDCLKSEL = 0;                     /* internal RC oscillator */
+  WDTC     = WDT_MS * WDT_PER_MS;
+  WDMOD    = WDEN | (WDT_RESET ? WDRESET : 0);
+  hb_feed();
+}
+
+/* Watch a task: it has to beat every 'budget' ticks while it is not
+   parked, the first time within 'budget' of this call. A late critical
+   task stops the watchdog feed, any late task is logged. */
+void hb_watch(OS_TID tid, U16 budget, U32 critical) {
+  TSK_INFO *t = tsk_info(tid);
+
+  if (t == NULL) return;
+  tsk_lock();
+  t->hb_last   = os_time_get();
+  t->hb_parked = 0;
+  t->hb_late   = 0;
+  t->hb_crit   = critical ? 1 : 0;
+  t->hb_budget = budget;
+  tsk_unlock();
+}
+
+/* Calling task is alive; its budget starts again now */
+void hb_beat(void) {
+  TSK_INFO *t = tsk_info(os_tsk_self());
+
+  if (t == NULL) return;
+  t->hb_last   = os_time_get();
+  t->hb_parked = 0;
+}
+
+/* Calling task goes into its main wait, which may last any time */
+void hb_park(void) {
+  TSK_INFO *t = tsk_info(os_tsk_self());
+
+  if (t != NULL) t->hb_parked = 1;
+}
+
+/* RSIR bits of the last reset (HB_RST_xxx) */
+U32 hb_cause(void) {
+  return hb_rsir;
+}
+
+/* Times a task was found late, and watchdog feeds, since reset */
+U32 hb_overruns(void) {
+  return hb_nover;
+}
+
+U32 hb_feeds(void) {
+  return hb_nfeed;
+}
+
+/* Monitor task; create exactly one, at the lowest priority */
+__task void hb_monitor(void) {
+  TSK_INFO *t;
+  U32 i, late, stall;
+  U16 age;
+
+  for (;;) {
+    os_dly_wait(HB_PERIOD);
+    stall = 0;
+    for (i = 1; i < os_tsk_info_cnt; i++) {
+      t = &os_tsk_info[i];
+      if (t->hb_budget == 0) continue;
+      tsk_lock();
+      age  = (U16)(os_time_get() - t->hb_last);
+      late = !t->hb_parked && age > t->hb_budget;
+      tsk_unlock();
+      if (!late) {
+        t->hb_late = 0;
+        continue;
+      }
+      if (t->hb_crit) stall = 1;
+      if (!t->hb_late) {
+        /* log outside the lock: the send may switch to the logger */
+        t->hb_late = 1;
+        t->hb_overruns++;
+        hb_nover++;
+        TRACE(TRC_HB_LATE, i, age);
+        log_put(LOG_SRC_HEALTH, LOG_ID_STALL, i, age);
+      }
+    }
+    if (!stall) hb_feed();
+  }
+}
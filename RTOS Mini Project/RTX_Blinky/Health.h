@@ -0,0 +1,28 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Health monitor definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __HEALTH_H
+#define __HEALTH_H
+
+#include "Config.h"                 /* WDT_RESET */
+
+#define HB_PERIOD       50          /* monitor period [ticks] */
+#define WDT_MS          2000        /* watchdog timeout [ms] */
+
+/* RSIR bits, as returned by hb_cause() */
+#define HB_RST_POR      0x01        /* power-on */
+#define HB_RST_EXT      0x02        /* RESET pin */
+#define HB_RST_WDT      0x04        /* watchdog timeout */
+#define HB_RST_BOD      0x08        /* brown-out */
+
+extern void hb_init (void);
+extern void hb_watch (OS_TID tid, U16 budget, U32 critical);
+extern void hb_beat (void);
+extern void hb_park (void);
+extern U32  hb_cause (void);
+extern U32  hb_overruns (void);
+extern U32  hb_feeds (void);
+extern __task void hb_monitor (void);
+
+#endif
@@ -0,0 +1,94 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Sensor history
+ *
+ *  One ring of signed 8-bit deltas per series: a stored sample costs one
+ *  byte instead of a formatted log line. 'last' holds the newest value,
+ *  so a query walks backwards from the head subtracting deltas and never
+ *  needs the (overwritten) oldest value. A step larger than a delta can
+ *  hold is spread over the following samples.
+ *
+ *  Each series has a single writer. hist_add() averages 'div' inputs per
+ *  stored sample, which sets the time covered by HIST_LEN samples.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "History.h"
+
+typedef struct {
+  S8   d[HIST_LEN];                 /* d[i] = sample[i] - sample[i-1] */
+  U16  head;                        /* next slot to write */
+  U16  cnt;                         /* valid samples, <= HIST_LEN */
+  U16  last;                        /* value of the newest sample */
+  U16  div;                         /* inputs per stored sample */
+  U16  n;                           /* inputs summed so far */
+  U32  sum;
+} HIST;
+
+static HIST hist[HIST_CNT];
+
+/* Clear series and set its decimation */
+void hist_init(U32 id, U32 div) {
+  HIST *h = &hist[id];
+
+  h->head = h->cnt = h->last = 0;
+  h->n    = 0;
+  h->sum  = 0;
+  h->div  = div ? div : 1;
+}
+
+/* Record one input; stores a sample every 'div' inputs */
+void hist_add(U32 id, U32 value) {
+  HIST *h = &hist[id];
+  S32   v, dv;
+
+  h->sum += value;
+  if (++h->n < h->div) return;
+  v      = (S32)(h->sum / h->n);
+  h->sum = 0;
+  h->n   = 0;
+
+  dv = h->cnt ? v - h->last : v;
+  if (dv >  127) dv =  127;
+  if (dv < -128) dv = -128;
+
+  /* the readers take head/cnt/last together */
+  tsk_lock();
+  h->d[h->head] = (S8)dv;
+  h->last = (U16)(h->last + dv);
+  if (++h->head == HIST_LEN) h->head = 0;
+  if (h->cnt < HIST_LEN) h->cnt++;
+  tsk_unlock();
+}
+
+/* Min/max/average of the newest n samples. Returns the number found.
+   Only the ring position is read locked; the walk is safe because the
+   writer would have to store HIST_LEN samples meanwhile to reach it. */
+U32 hist_query(U32 id, U32 n, HIST_STAT *st) {
+  HIST *h = &hist[id];
+  U32   i, cnt, sum;
+  S32   v;
+
+  tsk_lock();
+  i   = h->head;
+  cnt = h->cnt;
+  v   = h->last;
+  tsk_unlock();
+
+  if (n > cnt) n = cnt;
+  st->cnt = (U16)n;
+  if (n == 0) {
+    st->min = st->max = st->avg = 0;
+    return 0;
+  }
+  st->min = 0xFFFF;
+  st->max = 0;
+  for (sum = 0, cnt = n; cnt; cnt--) {
+    if (v < st->min) st->min = (U16)v;
+    if (v > st->max) st->max = (U16)v;
+    sum += v;
+    i = i ? i - 1 : HIST_LEN - 1;
+    v -= h->d[i];
+  }
+  st->avg = (U16)((sum + n / 2) / n);
+  return n;
+}
@@ -0,0 +1,29 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Sensor history definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __HISTORY_H
+#define __HISTORY_H
+
+#include "Config.h"                 /* CFG_HIST_LEN */
+
+/* Series ids */
+#define HIST_TEMP       0
+#define HIST_LIGHT      1
+#define HIST_CNT        2
+
+#define HIST_LEN        CFG_HIST_LEN /* samples (bytes) per series */
+
+/* Result of a window query */
+typedef struct {
+  U16  min;
+  U16  max;
+  U16  avg;
+  U16  cnt;                         /* samples found, <= window */
+} HIST_STAT;
+
+extern void hist_init (U32 id, U32 div);
+extern void hist_add (U32 id, U32 value);
+extern U32  hist_query (U32 id, U32 n, HIST_STAT *st);
+
+#endif
@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Host build: RTX API subset
+ *
+ *  Stands in for the Keil RTL.h when the application is compiled for the
+ *  host (see rtx_host.c). Only the part of the RTX API used by the
+ *  application is declared.
+ *----------------------------------------------------------------------------*/
+
+#ifndef __RTL_H__
+#define __RTL_H__
+
+#include <stddef.h>
+
+typedef unsigned char       U8;
+typedef signed char         S8;
+typedef unsigned short      U16;
+typedef signed short        S16;
+typedef unsigned int        U32;
+typedef signed int          S32;
+typedef unsigned long long  U64;
+typedef signed long long    S64;
+typedef unsigned char       BIT;
+typedef unsigned int        BOOL;
+
+#define __TRUE          1
+#define __FALSE         0
+
+typedef U32     OS_TID;
+typedef void   *OS_ID;
+typedef U32     OS_RESULT;
+typedef void  (*FUNCP)(void);
+
+#define OS_R_TMO        0x01
+#define OS_R_EVT        0x02
+#define OS_R_SEM        0x03
+#define OS_R_MBX        0x04
+#define OS_R_MUT        0x05
+#define OS_R_OK         0x00
+#define OS_R_NOK        0xff
+
+/* Keil keywords and intrinsics */
+#define __task
+#define __irq
+#define __disable_irq() host_disable_irq()
+#define __enable_irq()  host_enable_irq()
+
+extern int  host_disable_irq (void);
+extern void host_enable_irq (void);
+
+/* Mutex: owner, nesting level, priority before inheritance */
+typedef struct {
+  OS_TID  owner;
+  U32     level;
+  U32     prio;
+  U64     t_lock;                   /* virtual time of the first lock */
+} OS_MUT;
+
+/* Mailbox: the same size formula as RTX, in pointer units */
+#define os_mbx_declare(name, cnt)   void *name[4 + (cnt)]
+
+/* Fixed block pools: header of 4 words, blocks rounded up to 8 bytes */
+#define _declare_box(pool, size, cnt) \
+        U32 pool[4 + (((size) + 7) / 8) * 2 * (cnt)]
+
+extern void      os_sys_init (FUNCP first);
+extern OS_TID    os_tsk_create_user (FUNCP task, U32 prio, void *stk, U16 size);
+extern void      os_tsk_delete_self (void);
+extern OS_TID    os_tsk_self (void);
+extern OS_RESULT os_tsk_prio (OS_TID tid, U8 prio);
+extern OS_RESULT os_tsk_prio_self (U8 prio);
+extern OS_TID    isr_tsk_get (void);
+extern void      tsk_lock (void);
+extern void      tsk_unlock (void);
+extern U32       os_suspend (void);
+extern void      os_resume (U32 sleep_time);
+
+extern OS_RESULT os_evt_wait_or (U16 flags, U16 timeout);
+extern OS_RESULT os_evt_wait_and (U16 flags, U16 timeout);
+extern void      os_evt_set (U16 flags, OS_TID tid);
+extern void      os_evt_clr (U16 flags, OS_TID tid);
+extern U16       os_evt_get (void);
+extern void      isr_evt_set (U16 flags, OS_TID tid);
+
+extern void      os_dly_wait (U16 delay);
+extern void      os_itv_set (U16 period);
+extern void      os_itv_wait (void);
+extern U16       os_time_get (void);
+
+extern void      os_mut_init (OS_ID mut);
+extern OS_RESULT os_mut_wait (OS_ID mut, U16 timeout);
+extern OS_RESULT os_mut_release (OS_ID mut);
+
+extern void      os_mbx_init (OS_ID mbx, U16 size);
+extern OS_RESULT os_mbx_send (OS_ID mbx, void *msg, U16 timeout);
+extern OS_RESULT os_mbx_wait (OS_ID mbx, void **msg, U16 timeout);
+
+extern int       _init_box (void *pool, U32 size, U32 bsize);
+extern void     *_alloc_box (void *pool);
+extern int       _free_box (void *pool, void *block);
+
+#endif
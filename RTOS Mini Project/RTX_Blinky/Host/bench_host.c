@@ -0,0 +1,96 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Host build: benchmark report
+ *
+ *  Printed to stderr when the simulated run ends (stdout is the
+ *  application's UART when HOST_UART is not set). Virtual times are
+ *  target estimates through HOST_SCALE; host CPU times are measured.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <stdio.h>
+#include <time.h>
+#include "TaskReg.h"
+#include "Log.h"
+#include "Output.h"
+#include "Adc.h"
+#include "Sensor.h"
+#include "Telem.h"
+#include "Flog.h"
+#include "Screen.h"
+#include "Health.h"
+#include "Wheel.h"
+#include "Rule.h"
+#include "host.h"
+
+#define MS(ns)          ((double)(ns) / 1e6)
+#define US(ns)          ((double)(ns) / 1e3)
+
+/* Latency percentile from the log2 bins: upper edge of the bin, at
+   most the maximum seen [us] */
+static U32 lat_pct(const LAT_HIST *h, U32 pct) {
+  U32 need = (h->cnt * pct + 99) / 100;
+  U32 sum = 0;
+  int i;
+
+  for (i = 0; i < LAT_BINS; i++) {
+    sum += h->bin[i];
+    if (sum >= need) break;
+  }
+  if (i + 1 >= LAT_BINS || (2u << i) > h->max) return h->max;
+  return 2u << i;
+}
+
+void host_report(void) {
+  const HOST_STATS *s = &host_stats;
+  double wall, sim;
+  U32 i, bytes;
+  clock_t c = clock();
+
+  wall = (double)c / CLOCKS_PER_SEC;
+  sim  = (double)host_now / 1e9;
+
+  fprintf(stderr, "\nsimulated %.0f s in %.2f s CPU (x%.0f), HOST_SCALE %u\n",
+          sim, wall, wall > 0 ? sim / wall : 0, s->cpu_scale);
+  fprintf(stderr, "virtual load %.2f%% (idle %.1f s), %u switches\n\n",
+          100.0 * (1.0 - (double)s->idle_ns / host_now),
+          (double)s->idle_ns / 1e9, s->switches);
+
+  fprintf(stderr, "task       prio  runs       cpu[ms]  load%%  wake p50/p99/max[us]\n");
+  for (i = 1; i <= HOST_TASKCNT; i++) {
+    const HOST_TSK *t = &s->tsk[i];
+    const char *name = os_tsk_info[i].name;
+
+    if (!t->used) continue;
+    fprintf(stderr, "%-10s %4u %7u %10.2f %6.2f  %u/%u/%u\n",
+            name ? name : "?", t->prio, t->runs, MS(t->cpu_ns),
+            100.0 * t->cpu_ns * s->cpu_scale / host_now,
+            lat_pct(&t->wake, 50), lat_pct(&t->wake, 99), t->wake.max);
+  }
+  fprintf(stderr, "isr        %12u %10.2f %6.2f\n\n", s->isr_cnt, MS(s->isr_ns),
+          100.0 * s->isr_ns * s->cpu_scale / host_now);
+
+  for (i = 0; i < HOST_MUTS && s->mut[i].mut; i++) {
+    const HOST_MUT *m = &s->mut[i];
+
+    fprintf(stderr, "mutex %u: %u locks, %u blocked, hold avg %.1f us max %.1f us\n",
+            i, m->locks, m->blocked,
+            m->locks ? US(m->hold_sum) / m->locks : 0, US(m->hold_max));
+  }
+  fprintf(stderr, "tsk_lock: %u sections, max %.1f us\n", s->lock_cnt,
+          US(s->lock_max));
+  fprintf(stderr, "mailbox: %u sent, %u received (%.1f/s), %u sends found it full\n",
+          s->mbx_sent, s->mbx_recv, s->mbx_recv / sim, s->mbx_full);
+
+  bytes = hw_uart_bytes();
+  fprintf(stderr, "uart: %u bytes (%.0f B/s)\n", bytes, bytes / sim);
+  fprintf(stderr, "log drops %u/%u/%u, output writes %u, adc overruns %u, "
+          "telemetry drops %u\n", log_drops(LOG_SRC_TEMP),
+          log_drops(LOG_SRC_LIGHT), log_drops(LOG_SRC_EMERG), out_writes(),
+          adc_overruns(), telem_drops());
+  fprintf(stderr, "flash log: %u pages, %u erases, %u errors\n",
+          s->flash_prog, s->flash_erase, flog_errors());
+  fprintf(stderr, "lcd: %u requests, %u frames\n", scr_posts(), scr_frames());
+  fprintf(stderr, "watchdog: %u feeds, %u timeouts, %u tasks found late\n",
+          s->wdt_feeds, s->wdt_timeouts, hb_overruns());
+  fprintf(stderr, "rules: %u tested, %u actions\n", rule_evals(), rule_fires());
+}
@@ -0,0 +1,74 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Host build: shim internals
+ *----------------------------------------------------------------------------*/
+
+#ifndef __HOST_H
+#define __HOST_H
+
+#include "Latency.h"
+
+#define HOST_TASKCNT    9           /* OS_TASKCNT in RTX_Config.c */
+#define HOST_TICK_NS    10000000ULL /* OS_TICK in RTX_Config.c */
+#define HOST_CLK_HZ     12000000ULL /* peripheral clock, CLK_HZ */
+#define HOST_MUTS       4           /* mutexes with statistics */
+
+/* Virtual time [ns] and tick count */
+extern U64 host_now;
+extern U32 host_ticks;
+
+/* Per task statistics */
+typedef struct {
+  U8       used;
+  U8       prio;
+  U64      cpu_ns;                  /* host CPU spent in the task */
+  U32      runs;                    /* times switched in */
+  LAT_HIST wake;                    /* ready -> running [virtual] */
+} HOST_TSK;
+
+/* Per mutex statistics */
+typedef struct {
+  void    *mut;
+  U32      locks;
+  U32      blocked;                 /* waits that had to block */
+  U64      hold_max;                /* [virtual ns] */
+  U64      hold_sum;
+} HOST_MUT;
+
+typedef struct {
+  U32      cpu_scale;               /* virtual ns per host ns */
+  U64      end_ns;                  /* simulated time */
+  U64      idle_ns;                 /* virtual time with no task ready */
+  U64      isr_ns;                  /* host CPU in ISRs */
+  U32      isr_cnt;
+  U32      switches;
+  U32      mbx_sent;
+  U32      mbx_recv;
+  U32      mbx_full;
+  U32      lock_cnt;                /* tsk_lock() sections */
+  U64      lock_max;                /* longest section [virtual ns] */
+  U32      flash_prog;              /* IAP page programs */
+  U32      flash_erase;             /* IAP sector erases */
+  U32      wdt_feeds;               /* valid watchdog feed sequences */
+  U32      wdt_timeouts;            /* watchdog expired (a reset on target) */
+  HOST_TSK tsk[HOST_TASKCNT + 1];
+  HOST_MUT mut[HOST_MUTS];
+} HOST_STATS;
+
+extern HOST_STATS host_stats;
+
+/* rtx_host.c */
+extern void host_sync (void);
+extern U64  host_clock (void);
+extern void host_isr (FUNCP isr);
+extern void host_busy (U64 ns);
+
+/* hw_host.c */
+extern void hw_init (void);
+extern U64  hw_next (void);
+extern void hw_fire (U64 t);
+extern U32  hw_uart_bytes (void);
+
+/* bench_host.c */
+extern void host_report (void);
+
+#endif
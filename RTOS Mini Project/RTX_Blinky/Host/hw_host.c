@@ -0,0 +1,392 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Host build: peripheral models
+ *
+ *  Just enough of the LPC2378 for the application: the VIC enable mask,
+ *  Timer 1 free-running with MR0/MR1 match, Timer 2/3 periodic with
+ *  reset on MR0, the ADC burst scan, UART0 with a 16 byte TX FIFO at
+ *  115200 Baud, the INT0 button, and the watchdog (feed and timeout,
+ *  which sets WDTOF but cannot reset the host). The firmware's register
+ *  stores land in plain variables; poll() picks up what changed since
+ *  the last look, which is at every kernel call and after every ISR.
+ *
+ *  Stimulus: the temperature follows a 20 min sine of 30 +/- 17 C, the
+ *  light level a 10 min sine of 50 +/- 45, both with a few counts of
+ *  noise. The button is pressed every 30 s and an 'H' arrives on the
+ *  UART one second before the end of the run. If HOST_UART names a file
+ *  the transmitted bytes are written to it.
+ *
+ *  IAP programs and erases the four flash sectors of Flog.c, with the
+ *  datasheet times as busy time. If HOST_FLASH names a file, the sectors
+ *  are loaded from it at start and saved to it after every change, so
+ *  the log survives from one run to the next.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+
+#define HOST_DEF(name)      volatile unsigned long name;
+HOST_REGS(HOST_DEF)
+
+volatile unsigned long host_ad0dr[8];
+volatile unsigned long host_u0thr[16];
+volatile unsigned int  host_u0thr_wr;
+volatile unsigned long host_vic_en[16], host_vic_clr[16];
+volatile unsigned int  host_vic_en_wr, host_vic_clr_wr;
+volatile unsigned long host_wdfeed[16];
+volatile unsigned int  host_wdfeed_wr;
+
+#define NEVER           (~0ULL)
+#define SEC             1000000000ULL
+#define ADC_SCAN_NS     5500        /* 2 channels of 11 clocks at 4 MHz */
+#define UART_CHAR_NS    86806       /* 10 bits at 115200 Baud */
+#define BUTTON_NS       (30 * SEC)
+#define FLASH_SEC0      24          /* Flog.c: 4 KB sectors 24..27 */
+#define FLASH_SECS      4
+#define FLASH_SEC_SIZE  4096
+#define FLASH_PROG_NS   1000000     /* 256 bytes */
+#define FLASH_ERASE_NS  100000000   /* one sector */
+#define WDT_COUNT_NS    1000        /* 4 MHz IRC / 4 */
+
+unsigned char host_flash[FLASH_SECS * FLASH_SEC_SIZE];
+
+#define VIC_T1          (1 << 5)
+#define VIC_UART0       (1 << 6)
+#define VIC_EINT0       (1 << 14)
+#define VIC_ADC         (1 << 18)
+#define VIC_T2          (1 << 26)
+#define VIC_T3          (1 << 27)
+
+static U32 vic_en;                  /* VICIntEnable as the VIC sees it */
+static U8  t2_on, t3_on, adc_on;
+static U64 t2_next, t3_next, adc_next, btn_next, rx_next, tx_next;
+static U64 t1_seen[2];              /* T1TC at the last MR0/MR1 check */
+static U32 tx_rd;                   /* next FIFO slot to shift out */
+static U8  thre_int;                /* THRE interrupt pending */
+static U8  rx_have, rx_char;
+static U32 uart_bytes;
+static FILE *uart_out;
+static const char *flash_file;
+static U8 flash_prep;               /* sectors prepared, bit 0 = FLASH_SEC0 */
+static U32 wdt_rd;                  /* next WDFEED store to look at */
+static U64 wdt_next;                /* watchdog timeout, NEVER until fed */
+static U32 noise_seed = 1;
+
+/* Clock counts <-> ns, split so that the products fit in 64 bits */
+static U64 clk_of(U64 ns) {
+  return ns / SEC * HOST_CLK_HZ + ns % SEC * HOST_CLK_HZ / SEC;
+}
+
+static U64 ns_of(U64 clk) {
+  return clk / HOST_CLK_HZ * SEC +
+         (clk % HOST_CLK_HZ * SEC + HOST_CLK_HZ - 1) / HOST_CLK_HZ;
+}
+
+static int noise(void) {
+  noise_seed = noise_seed * 1103515245 + 12345;
+  return (int)((noise_seed >> 16) % 9) - 4;
+}
+
+/* ADC counts for AD0.0 (temperature) and AD0.1 (light) at time t */
+static U32 adc_value(U32 ch, U64 t) {
+  double s = (double)t / SEC;
+  double v;
+
+  if (ch == 0) {
+    v = (30.0 + 17.0 * sin(2 * M_PI * s / 1200)) * 1024 / 50;
+  } else {
+    v = (50.0 + 45.0 * sin(2 * M_PI * s / 600)) * 1024 / 100;
+  }
+  v += noise();
+  if (v < 0)    v = 0;
+  if (v > 1023) v = 1023;
+  return (U32)v;
+}
+
+static U32 tx_level(void) {
+  return host_u0thr_wr - tx_rd;
+}
+
+/* Match period of Timer 2/3 [ns] */
+static U64 timer_period(unsigned long mr, unsigned long pr) {
+  return ns_of((U64)(mr + 1) * (pr + 1));
+}
+
+/* Pick up register stores made since the last call */
+static void poll(void) {
+  U64 now = host_now;
+  int i;
+
+  /* enable stores since the last poll; clears first, as Serial.c uses them */
+  for (i = 0; i < 16; i++) {
+    vic_en &= ~host_vic_clr[i];
+    host_vic_clr[i] = 0;
+  }
+  for (i = 0; i < 16; i++) {
+    vic_en |= host_vic_en[i];
+    host_vic_en[i] = 0;
+  }
+
+  if ((T2TCR & 3) == 1) {
+    if (!t2_on) t2_next = now + timer_period(T2MR0, T2PR);
+    t2_on = 1;
+  } else {
+    t2_on = 0;
+  }
+  if ((T3TCR & 3) == 1) {
+    if (!t3_on) t3_next = now + timer_period(T3MR0, T3PR);
+    t3_on = 1;
+  } else {
+    t3_on = 0;
+  }
+  if (AD0CR & (1 << 16)) {
+    if (!adc_on) adc_next = now + ADC_SCAN_NS;
+    adc_on = 1;
+  } else {
+    adc_on = 0;
+  }
+  if (tx_level() && tx_next == NEVER) tx_next = now + UART_CHAR_NS;
+
+  /* a feed restarts the count from WDTC; the first one starts it */
+  for (; wdt_rd != host_wdfeed_wr; wdt_rd++) {
+    if ((WDMOD & 1) && wdt_rd > 0 && host_wdfeed[wdt_rd & 15] == 0x55 &&
+        host_wdfeed[(wdt_rd - 1) & 15] == 0xAA) {
+      wdt_next = now + (U64)WDTC * WDT_COUNT_NS;
+      host_stats.wdt_feeds++;
+    }
+  }
+}
+
+static int uart_irq(void) {
+  return (thre_int && (U0IER & 0x02)) || (rx_have && (U0IER & 0x01));
+}
+
+/* Time of the next T1 match on MR0 (n = 0) or MR1, NEVER while its
+   interrupt is off. Task run time is charged in steps, so the counter
+   is compared from where it was last seen, not from now: a match passed
+   in between stays due until it is taken. */
+static U64 t1_match(int n) {
+  U32 mr = n ? (U32)T1MR1 : (U32)T1MR0;
+  U64 t;
+
+  if (!(T1MCR & (1 << 3 * n))) {
+    t1_seen[n] = clk_of(host_now);
+    return NEVER;
+  }
+  t = ns_of(t1_seen[n] + (U32)(mr - (U32)t1_seen[n]));
+  if (t > host_now) t1_seen[n] = clk_of(host_now);
+  return t;
+}
+
+/* T1IR flags of the matches due at t */
+static U32 t1_flags(U64 t) {
+  return (t1_match(0) <= t) | (t1_match(1) <= t) << 1;
+}
+
+void hw_init(void) {
+  const char *f = getenv("HOST_UART");
+  FILE *fl;
+
+  if (f) uart_out = fopen(f, "wb");
+  memset(host_flash, 0xFF, sizeof(host_flash));
+  flash_file = getenv("HOST_FLASH");
+  if (flash_file && (fl = fopen(flash_file, "rb")) != NULL) {
+    if (fread(host_flash, 1, sizeof(host_flash), fl) != sizeof(host_flash)) {
+      memset(host_flash, 0xFF, sizeof(host_flash));
+    }
+    fclose(fl);
+  }
+  tx_next  = NEVER;
+  wdt_next = NEVER;
+  RSIR     = 0x01;                  /* power-on reset */
+  btn_next = BUTTON_NS;
+  rx_next  = host_stats.end_ns > SEC ? host_stats.end_ns - SEC : NEVER;
+}
+
+/* Virtual time of the next peripheral event */
+U64 hw_next(void) {
+  U64 t = NEVER, m;
+
+  poll();
+  if ((vic_en & VIC_UART0) && uart_irq()) return host_now;
+  if (vic_en & VIC_T1) {
+    t = t1_match(0);
+    m = t1_match(1);
+    if (m < t) t = m;
+  }
+  if (t2_on && t2_next < t) t = t2_next;
+  if (t3_on && t3_next < t) t = t3_next;
+  if (adc_on && adc_next < t) t = adc_next;
+  if (tx_next < t)  t = tx_next;
+  if (btn_next < t) t = btn_next;
+  if (rx_next < t)  t = rx_next;
+  if (wdt_next < t) t = wdt_next;
+  return t;
+}
+
+/* Sources enabled, with the stores made so far */
+unsigned long host_vic_enabled(void) {
+  poll();
+  return vic_en;
+}
+
+static void call(U32 mask, unsigned long vect) {
+  if (vic_en & mask) host_isr((FUNCP)vect);
+  poll();
+}
+
+/* Handle the event due at t, in VIC priority order */
+void hw_fire(U64 t) {
+  U32 ir;
+  int i;
+
+  poll();
+  if (adc_on && adc_next <= t) {
+    for (i = 0; i < 2; i++) {
+      host_ad0dr[i] = (1UL << 31) | (adc_value(i, t) << 6);
+    }
+    adc_next = NEVER;
+    call(VIC_ADC, VICVectAddr18);
+  } else if ((vic_en & VIC_UART0) && uart_irq()) {
+    call(VIC_UART0, VICVectAddr6);
+  } else if (t3_on && t3_next <= t) {
+    t3_next += timer_period(T3MR0, T3PR);
+    call(VIC_T3, VICVectAddr27);
+  } else if ((vic_en & VIC_T1) && (ir = t1_flags(t)) != 0) {
+    T1IR = ir;
+    call(VIC_T1, VICVectAddr5);
+  } else if (t2_on && t2_next <= t) {
+    t2_next += timer_period(T2MR0, T2PR);
+    call(VIC_T2, VICVectAddr26);
+  } else if (btn_next <= t) {
+    btn_next += BUTTON_NS;
+    call(VIC_EINT0, VICVectAddr14);
+  } else if (tx_next <= t) {
+    /* one character leaves the shift register */
+    if (uart_out) fputc((int)(host_u0thr[tx_rd & 15] & 0xFF), uart_out);
+    tx_rd++;
+    uart_bytes++;
+    if (tx_level()) {
+      tx_next += UART_CHAR_NS;
+    } else {
+      tx_next  = NEVER;
+      thre_int = 1;
+    }
+  } else if (rx_next <= t) {
+    rx_next = NEVER;
+    rx_char = 'H';
+    rx_have = 1;
+  } else if (wdt_next <= t) {
+    /* with WDRESET the target would restart here */
+    wdt_next = NEVER;
+    WDMOD   |= 0x04;                /* WDTOF */
+    host_stats.wdt_timeouts++;
+  }
+}
+
+static void flash_save(void) {
+  FILE *fl;
+
+  if (flash_file && (fl = fopen(flash_file, "wb")) != NULL) {
+    fwrite(host_flash, 1, sizeof(host_flash), fl);
+    fclose(fl);
+  }
+}
+
+/* Prepared sector range -> bit mask, 0 if outside the model */
+static U8 flash_mask(U32 first, U32 last) {
+  if (first < FLASH_SEC0 || last >= FLASH_SEC0 + FLASH_SECS || first > last) {
+    return 0;
+  }
+  return (U8)(((2u << (last - FLASH_SEC0)) - 1) &
+              ~((1u << (first - FLASH_SEC0)) - 1));
+}
+
+/* IAP commands 50 (prepare), 51 (copy RAM to flash), 52 (erase). Flash
+   bits only go from 1 to 0 when programmed. */
+void host_iap(unsigned int *cmd, unsigned int *res) {
+  U32 off, i;
+  U8 m;
+
+  switch (cmd[0]) {
+    case 50:
+      m = flash_mask(cmd[1], cmd[2]);
+      flash_prep |= m;
+      res[0] = m ? 0 : 7;           /* INVALID_SECTOR */
+      break;
+    case 51:
+      off = cmd[1] - (U32)host_flash;
+      if (off >= sizeof(host_flash) || off % 256 || cmd[3] != 256) {
+        res[0] = 3;                 /* DST_ADDR_ERROR */
+        break;
+      }
+      if (!(flash_prep & (1 << (off / FLASH_SEC_SIZE)))) {
+        res[0] = 9;                 /* SECTOR_NOT_PREPARED */
+        break;
+      }
+      for (i = 0; i < 256; i++) {
+        host_flash[off + i] &= ((U8 *)(size_t)cmd[2])[i];
+      }
+      flash_prep = 0;
+      host_stats.flash_prog++;
+      host_busy(FLASH_PROG_NS);
+      flash_save();
+      res[0] = 0;
+      break;
+    case 52:
+      m = flash_mask(cmd[1], cmd[2]);
+      if (m == 0 || (m & flash_prep) != m) {
+        res[0] = m ? 9 : 7;
+        break;
+      }
+      for (i = 0; i < FLASH_SECS; i++) {
+        if (m & (1 << i)) {
+          memset(host_flash + i * FLASH_SEC_SIZE, 0xFF, FLASH_SEC_SIZE);
+        }
+      }
+      flash_prep = 0;
+      host_stats.flash_erase++;
+      host_busy(FLASH_ERASE_NS);
+      flash_save();
+      res[0] = 0;
+      break;
+    default:
+      res[0] = 1;                   /* INVALID_COMMAND */
+      break;
+  }
+}
+
+U32 hw_uart_bytes(void) {
+  if (uart_out) fflush(uart_out);
+  return uart_bytes;
+}
+
+unsigned long host_t1tc(void) {
+  return (unsigned long)(U32)clk_of(host_clock());
+}
+
+unsigned long host_u0lsr(void) {
+  unsigned long lsr = 0;
+
+  if (rx_have) lsr |= 0x01;
+  if (tx_level() == 0) lsr |= 0x60; /* THRE, TEMT */
+  return lsr;
+}
+
+unsigned long host_u0iir(void) {
+  if (rx_have && (U0IER & 0x01)) return 0x04;
+  if (thre_int && (U0IER & 0x02)) {
+    thre_int = 0;                   /* cleared by reading IIR */
+    return 0x02;
+  }
+  return 0x01;
+}
+
+unsigned long host_u0rbr(void) {
+  rx_have = 0;
+  return rx_char;
+}
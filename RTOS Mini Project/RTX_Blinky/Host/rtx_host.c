@@ -0,0 +1,715 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Host build: RTX kernel shim
+ *
+ *  Runs the unmodified application on a POSIX host. Every RTX task is a
+ *  pthread, but only one thread runs at a time: the 'cpu' mutex is the
+ *  processor and 'cur' the task that owns it. Scheduling follows RTX:
+ *  the highest priority ready task runs, a wake-up of a higher priority
+ *  task preempts at once unless the switch is locked.
+ *
+ *  Time is virtual. The host CPU time a task uses is scaled by
+ *  HOST_SCALE (default 40, roughly a 72 MHz ARM7 against a current PC)
+ *  and added to the virtual clock; when no task is ready the clock jumps
+ *  to the next tick or peripheral event. Interrupts (hw_host.c) are taken
+ *  at kernel calls, so ISR latency is bounded by the run time between two
+ *  such calls. A run of HOST_SECONDS (default 3600) simulated seconds
+ *  takes a few seconds of wall time; the benchmark report (bench_host.c)
+ *  goes to stderr at the end. Only task and handler code is billed, the
+ *  shim's own work is not, but every ISR still carries the cost of two
+ *  clock_gettime() calls.
+ *
+ *  Build, from RTX_Blinky (the Host directory replaces RTL.h/LPC23xx.H;
+ *  -no-pie keeps the (U32) casts of vector addresses intact on 64 bit):
+ *
+ *    gcc -O2 -no-pie -IHost -I. -o blinky_host Blinky.c LCD.c Log.c
+ *        Ceiling.c TaskReg.c Sensor.c Clock.c Profile.c Adc.c Filter.c
+ *        Output.c History.c Sched.c Latency.c Serial.c Trace.c Telem.c
+ *        Wheel.c SensTab.c Flog.c Screen.c Health.c Rule.c Vic.c
+ *        Host/rtx_host.c Host/hw_host.c Host/bench_host.c -lpthread -lm
+ *
+ *  Not modelled: task stacks (threads use their own, so tsk_stack_used()
+ *  reports 0), round-robin, os_sem_*, and RTX_Config.c itself.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "TaskReg.h"
+#include "Profile.h"
+#include "host.h"
+
+/* Task registry storage, normally in RTX_Config.c */
+TSK_INFO     os_tsk_info[HOST_TASKCNT + 1];
+U32 const    os_tsk_info_cnt = HOST_TASKCNT + 1;
+
+enum { T_FREE, T_READY, T_DLY, T_ITV, T_EVT, T_MUT, T_MBX_W, T_MBX_S };
+
+typedef struct {
+  U8              state;
+  U8              prio;
+  U8              has_tmo;
+  U8              wait_and;
+  FUNCP           func;
+  pthread_t       th;
+  pthread_cond_t  cv;
+  U16             evt;              /* pending event flags */
+  U16             wait;             /* flags waited for */
+  U16             got;              /* flags that ended the last wait */
+  U32             tmo;              /* timeout tick */
+  U32             itv;              /* interval period [ticks] */
+  U32             itv_next;         /* next interval tick */
+  OS_RESULT       ret;
+  void           *obj;              /* mutex or mailbox waited for */
+  void           *msg;              /* mailbox message in transfer */
+  U32             seq;              /* ready order, for FIFO ties */
+  U64             ready_ns;
+  struct timespec mark;             /* thread CPU time at last charge */
+} TCB;
+
+U64 host_now;
+U32 host_ticks;
+HOST_STATS host_stats;
+
+static pthread_mutex_t cpu = PTHREAD_MUTEX_INITIALIZER;
+static TCB  tcb[HOST_TASKCNT + 1];  /* index = task id, 0 unused */
+static TCB *cur;
+static U32  ready_seq;
+static U32  lock_depth;
+static U64  lock_start;
+static int  irq_off;
+static int  in_isr;
+
+#define TID(t)          ((OS_TID)((t) - tcb))
+
+/*--------------------------- time ------------------------------------------*/
+
+static U64 ts_ns(const struct timespec *a, const struct timespec *b) {
+  return (U64)(b->tv_sec - a->tv_sec) * 1000000000ULL + b->tv_nsec - a->tv_nsec;
+}
+
+/* Add the CPU used by the running thread since the last charge */
+static void charge(void) {
+  struct timespec now;
+  U64 d;
+
+  if (cur == NULL) return;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  d = ts_ns(&cur->mark, &now);
+  cur->mark = now;
+  if (in_isr) {
+    host_stats.isr_ns += d;
+  } else {
+    host_stats.tsk[TID(cur)].cpu_ns += d;
+  }
+  host_now += d * host_stats.cpu_scale;
+}
+
+/* Restart the CPU measurement without billing: the time since the last
+   charge was spent in the shim itself */
+static void resync(void) {
+  if (cur != NULL) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cur->mark);
+}
+
+/* Move the virtual clock forward to t with no task running */
+static void idle_to(U64 t) {
+  if (t > host_now) {
+    host_stats.idle_ns += t - host_now;
+    host_now = t;
+  }
+}
+
+static void make_ready(TCB *t, OS_RESULT ret) {
+  t->state    = T_READY;
+  t->has_tmo  = 0;
+  t->ret      = ret;
+  t->seq      = ++ready_seq;
+  t->ready_ns = host_now;
+}
+
+/* One RTX tick: timeouts and intervals */
+static void tick(void) {
+  TCB *t;
+
+  host_ticks++;
+  for (t = &tcb[1]; t <= &tcb[HOST_TASKCNT]; t++) {
+    if (t->state == T_ITV && (S32)(host_ticks - t->itv_next) >= 0) {
+      t->itv_next += t->itv;
+      make_ready(t, OS_R_OK);
+    } else if (t->state > T_READY && t->has_tmo &&
+               (S32)(host_ticks - t->tmo) >= 0) {
+      make_ready(t, OS_R_TMO);
+    }
+  }
+}
+
+/* Run ticks and peripheral events up to virtual time 'until' */
+static void advance(U64 until) {
+  U64 t_tick, t_hw;
+
+  for (;;) {
+    if (host_now >= host_stats.end_ns) {
+      host_report();
+      exit(0);
+    }
+    t_tick = (U64)(host_ticks + 1) * HOST_TICK_NS;
+    t_hw   = irq_off ? ~0ULL : hw_next();
+    if (t_tick <= t_hw) {
+      if (t_tick > until) break;
+      idle_to(t_tick);
+      tick();
+    } else {
+      if (t_hw > until) break;
+      idle_to(t_hw);
+      hw_fire(t_hw);
+    }
+  }
+  idle_to(until);
+}
+
+/* Highest priority ready task: the running one on a tie, otherwise
+   the one that has been ready longest */
+static TCB *pick(void) {
+  TCB *t, *best = NULL;
+
+  for (t = &tcb[1]; t <= &tcb[HOST_TASKCNT]; t++) {
+    if (t->state != T_READY) continue;
+    if (best == NULL || t->prio > best->prio) {
+      best = t;
+    } else if (t->prio == best->prio && best != cur &&
+               (t == cur || t->seq < best->seq)) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+/* Hand the CPU to 'next' and wait until it comes back */
+static void switch_to(TCB *next) {
+  TCB *self = cur;
+
+  if (next == self) return;
+  resync();
+  host_stats.switches++;
+  host_stats.tsk[TID(next)].runs++;
+  lat_add(&host_stats.tsk[TID(next)].wake,
+          (U32)((host_now - next->ready_ns) * HOST_CLK_HZ / 1000000000ULL));
+  cur = next;
+  pthread_cond_signal(&next->cv);
+  if (self == NULL) return;
+  if (self->state == T_FREE) {
+    pthread_mutex_unlock(&cpu);
+    pthread_exit(NULL);
+  }
+  while (cur != self) pthread_cond_wait(&self->cv, &cpu);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &self->mark);
+}
+
+/* The running task blocked or was deleted: run the next one, idling
+   the virtual clock until something is ready */
+static void reschedule(void) {
+  TCB *next;
+  U64 t, h;
+
+  charge();
+  if ((next = pick()) == NULL) {
+    prof_sleep();                   /* as the tickless idle demon does */
+    do {
+      /* idle: jump to the next tick or peripheral event */
+      t = (U64)(host_ticks + 1) * HOST_TICK_NS;
+      h = hw_next();
+      advance(h < t ? h : t);
+    } while ((next = pick()) == NULL);
+    prof_wake();
+  }
+  switch_to(next);
+}
+
+/* Preempt the running task if a higher priority one is ready */
+static void preempt(void) {
+  TCB *next;
+
+  if (lock_depth || irq_off || in_isr || cur == NULL) return;
+  next = pick();
+  if (next != NULL && next != cur && next->prio > cur->prio) switch_to(next);
+}
+
+/* Kernel entry: account CPU, take due interrupts, maybe preempt */
+void host_sync(void) {
+  if (in_isr || cur == NULL) return;
+  charge();
+  if (!irq_off) advance(host_now);
+  preempt();
+  resync();
+}
+
+static OS_RESULT block(U8 state, U16 timeout) {
+  cur->state = state;
+  if (timeout != 0xFFFF) {
+    cur->has_tmo = 1;
+    cur->tmo     = host_ticks + timeout;
+  }
+  reschedule();
+  return cur->ret;
+}
+
+/* Run an interrupt handler; only the handler itself is billed */
+void host_isr(FUNCP isr) {
+  resync();
+  in_isr = 1;
+  isr();
+  charge();
+  in_isr = 0;
+  host_stats.isr_cnt++;
+}
+
+/* The running code keeps the CPU for 'ns' of virtual time that no host
+   code stands for (flash programming in hw_host.c) */
+void host_busy(U64 ns) {
+  charge();
+  if (in_isr) {
+    host_stats.isr_ns += ns / host_stats.cpu_scale;
+  } else if (cur != NULL) {
+    host_stats.tsk[TID(cur)].cpu_ns += ns / host_stats.cpu_scale;
+  }
+  host_now += ns;
+  resync();
+}
+
+/* Timer read: account the CPU used so far, no interrupts taken */
+U64 host_clock(void) {
+  charge();
+  return host_now;
+}
+
+int host_disable_irq(void) {
+  int was = irq_off;
+
+  irq_off = 1;
+  return was;
+}
+
+void host_enable_irq(void) {
+  irq_off = 0;
+  host_sync();
+}
+
+/* Runtime error: RTX_Config.c stops in a loop until the watchdog resets
+   the chip; the host reports and ends the run */
+void os_error(U32 err_code) {
+  fprintf(stderr, "os_error 0x%x\n", err_code);
+  host_report();
+  exit(1);
+}
+
+/*--------------------------- tasks -----------------------------------------*/
+
+static void *thread_main(void *arg) {
+  TCB *self = arg;
+
+  pthread_mutex_lock(&cpu);
+  while (cur != self) pthread_cond_wait(&self->cv, &cpu);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &self->mark);
+  self->func();
+  os_tsk_delete_self();
+  return NULL;
+}
+
+OS_TID os_tsk_create_user(FUNCP task, U32 prio, void *stk, U16 size) {
+  TCB *t;
+
+  (void)stk; (void)size;
+  host_sync();
+  for (t = &tcb[1]; t <= &tcb[HOST_TASKCNT]; t++) {
+    if (t->state == T_FREE) break;
+  }
+  if (t > &tcb[HOST_TASKCNT]) return 0;
+  memset(t, 0, sizeof(*t));
+  t->func = task;
+  t->prio = (U8)prio;
+  pthread_cond_init(&t->cv, NULL);
+  make_ready(t, OS_R_OK);
+  host_stats.tsk[TID(t)].used = 1;
+  host_stats.tsk[TID(t)].prio = t->prio;
+  pthread_create(&t->th, NULL, thread_main, t);
+  pthread_detach(t->th);
+  preempt();
+  return TID(t);
+}
+
+void os_tsk_delete_self(void) {
+  charge();
+  cur->state = T_FREE;
+  reschedule();
+}
+
+OS_TID os_tsk_self(void) {
+  return cur ? TID(cur) : 0;
+}
+
+OS_TID isr_tsk_get(void) {
+  return (cur && cur->state == T_READY) ? TID(cur) : 0;
+}
+
+OS_RESULT os_tsk_prio(OS_TID tid, U8 prio) {
+  if (tid == 0 || tid > HOST_TASKCNT || tcb[tid].state == T_FREE) return OS_R_NOK;
+  tcb[tid].prio = prio;
+  host_stats.tsk[tid].prio = prio;
+  preempt();
+  return OS_R_OK;
+}
+
+OS_RESULT os_tsk_prio_self(U8 prio) {
+  cur->prio = prio;
+  host_stats.tsk[TID(cur)].prio = prio;
+  preempt();
+  return OS_R_OK;
+}
+
+void tsk_lock(void) {
+  if (lock_depth++ == 0) {
+    charge();
+    lock_start = host_now;
+  }
+}
+
+void tsk_unlock(void) {
+  U64 d;
+
+  if (lock_depth && --lock_depth == 0) {
+    charge();
+    d = host_now - lock_start;
+    host_stats.lock_cnt++;
+    if (d > host_stats.lock_max) host_stats.lock_max = d;
+    host_sync();
+  }
+}
+
+/* Kernel held over a flash IAP call (Flog.c). The host tick is not an
+   interrupt that can be lost: advance() runs every tick of the busy time
+   afterwards, so there is nothing to re-sync and the stretch of the tick
+   timer (RTX_Config.c) is a no-op. Not counted as a tsk_lock section. */
+U32 os_suspend(void) {
+  lock_depth++;
+  return 0;
+}
+
+void os_resume(U32 sleep_time) {
+  if (lock_depth && --lock_depth == 0) host_sync();
+}
+
+void os_tick_hold(void) {
+}
+
+U32 os_tick_release(void) {
+  return 0;
+}
+
+void os_sys_init(FUNCP first) {
+  const char *s;
+
+  s = getenv("HOST_SCALE");
+  host_stats.cpu_scale = s ? (U32)atoi(s) : 40;
+  s = getenv("HOST_SECONDS");
+  host_stats.end_ns = (U64)(s ? atoi(s) : 3600) * 1000000000ULL;
+
+  hw_init();
+  pthread_cond_init(&tcb[0].cv, NULL);
+  pthread_mutex_lock(&cpu);
+  os_tsk_create_user(first, 1, NULL, 0);
+  switch_to(pick());
+  /* the main thread only holds the process open */
+  for (;;) pthread_cond_wait(&tcb[0].cv, &cpu);
+}
+
+/*--------------------------- events ----------------------------------------*/
+
+static OS_RESULT evt_wait(U16 flags, U16 timeout, int all) {
+  U16 have;
+
+  host_sync();
+  have = cur->evt & flags;
+  if (all ? (have == flags) : (have != 0)) {
+    cur->got  = have;
+    cur->evt &= ~have;
+    return OS_R_EVT;
+  }
+  if (timeout == 0) return OS_R_TMO;
+  cur->wait     = flags;
+  cur->wait_and = (U8)all;
+  return block(T_EVT, timeout);
+}
+
+OS_RESULT os_evt_wait_or(U16 flags, U16 timeout) {
+  return evt_wait(flags, timeout, 0);
+}
+
+OS_RESULT os_evt_wait_and(U16 flags, U16 timeout) {
+  return evt_wait(flags, timeout, 1);
+}
+
+void isr_evt_set(U16 flags, OS_TID tid) {
+  TCB *t;
+  U16 have;
+
+  if (tid == 0 || tid > HOST_TASKCNT) return;
+  t = &tcb[tid];
+  if (t->state == T_FREE) return;
+  t->evt |= flags;
+  if (t->state == T_EVT) {
+    have = t->evt & t->wait;
+    if (t->wait_and ? (have == t->wait) : (have != 0)) {
+      t->got  = have;
+      t->evt &= ~have;
+      make_ready(t, OS_R_EVT);
+    }
+  }
+}
+
+void os_evt_set(U16 flags, OS_TID tid) {
+  isr_evt_set(flags, tid);
+  host_sync();
+}
+
+void os_evt_clr(U16 flags, OS_TID tid) {
+  if (tid != 0 && tid <= HOST_TASKCNT) tcb[tid].evt &= ~flags;
+}
+
+U16 os_evt_get(void) {
+  return cur->got;
+}
+
+/*--------------------------- time ------------------------------------------*/
+
+void os_dly_wait(U16 delay) {
+  host_sync();
+  block(T_DLY, delay);
+}
+
+void os_itv_set(U16 period) {
+  cur->itv      = period;
+  cur->itv_next = host_ticks + period;
+}
+
+void os_itv_wait(void) {
+  host_sync();
+  if ((S32)(host_ticks - cur->itv_next) >= 0) {
+    cur->itv_next += cur->itv;      /* release already passed */
+    return;
+  }
+  block(T_ITV, 0xFFFF);
+}
+
+U16 os_time_get(void) {
+  host_sync();
+  return (U16)host_ticks;
+}
+
+/*--------------------------- mutexes ---------------------------------------*/
+
+static HOST_MUT *mut_stat(void *m) {
+  int i;
+
+  for (i = 0; i < HOST_MUTS; i++) {
+    if (host_stats.mut[i].mut == m) return &host_stats.mut[i];
+    if (host_stats.mut[i].mut == NULL) {
+      host_stats.mut[i].mut = m;
+      return &host_stats.mut[i];
+    }
+  }
+  return NULL;
+}
+
+static void mut_take(OS_MUT *m, TCB *t) {
+  HOST_MUT *st = mut_stat(m);
+
+  m->owner  = TID(t);
+  m->level  = 1;
+  m->prio   = t->prio;
+  m->t_lock = host_now;
+  if (st) st->locks++;
+}
+
+void os_mut_init(OS_ID mut) {
+  memset(mut, 0, sizeof(OS_MUT));
+}
+
+OS_RESULT os_mut_wait(OS_ID mut, U16 timeout) {
+  OS_MUT *m = mut;
+  HOST_MUT *st;
+  TCB *o;
+
+  host_sync();
+  if (m->owner == 0) {
+    mut_take(m, cur);
+    return OS_R_OK;
+  }
+  if (m->owner == TID(cur)) {
+    m->level++;
+    return OS_R_OK;
+  }
+  if (timeout == 0) return OS_R_TMO;
+  st = mut_stat(m);
+  if (st) st->blocked++;
+  /* priority inheritance */
+  o = &tcb[m->owner];
+  if (o->prio < cur->prio) o->prio = cur->prio;
+  cur->obj = m;
+  return block(T_MUT, timeout);     /* OS_R_MUT once handed over */
+}
+
+OS_RESULT os_mut_release(OS_ID mut) {
+  OS_MUT *m = mut;
+  HOST_MUT *st;
+  TCB *t, *w = NULL;
+  U64 d;
+
+  host_sync();
+  if (m->owner != TID(cur)) return OS_R_NOK;
+  if (--m->level) return OS_R_OK;
+  cur->prio = (U8)m->prio;          /* drop inherited priority */
+  st = mut_stat(m);
+  d  = host_now - m->t_lock;
+  if (st) {
+    st->hold_sum += d;
+    if (d > st->hold_max) st->hold_max = d;
+  }
+  m->owner = 0;
+  for (t = &tcb[1]; t <= &tcb[HOST_TASKCNT]; t++) {
+    if (t->state == T_MUT && t->obj == m && (w == NULL || t->prio > w->prio)) w = t;
+  }
+  if (w != NULL) {
+    mut_take(m, w);
+    make_ready(w, OS_R_MUT);
+  }
+  preempt();
+  return OS_R_OK;
+}
+
+/*--------------------------- mailboxes -------------------------------------*/
+/* Layout in pointer units: [0] capacity, [1] first, [2] count, [4..] ring */
+
+#define MBX_CAP(b)      ((U32)(size_t)(b)[0])
+#define MBX_FIRST(b)    ((U32)(size_t)(b)[1])
+#define MBX_CNT(b)      ((U32)(size_t)(b)[2])
+
+static TCB *mbx_waiter(void *mbx, U8 state) {
+  TCB *t, *w = NULL;
+
+  for (t = &tcb[1]; t <= &tcb[HOST_TASKCNT]; t++) {
+    if (t->state == state && t->obj == mbx &&
+        (w == NULL || t->prio > w->prio)) w = t;
+  }
+  return w;
+}
+
+static void mbx_put(void **b, void *msg) {
+  b[4 + (MBX_FIRST(b) + MBX_CNT(b)) % MBX_CAP(b)] = msg;
+  b[2] = (void *)(size_t)(MBX_CNT(b) + 1);
+}
+
+static void *mbx_get(void **b) {
+  void *msg = b[4 + MBX_FIRST(b)];
+
+  b[1] = (void *)(size_t)((MBX_FIRST(b) + 1) % MBX_CAP(b));
+  b[2] = (void *)(size_t)(MBX_CNT(b) - 1);
+  return msg;
+}
+
+void os_mbx_init(OS_ID mbx, U16 size) {
+  void **b = mbx;
+
+  memset(b, 0, size);
+  b[0] = (void *)(size_t)(size / sizeof(void *) - 4);
+}
+
+OS_RESULT os_mbx_send(OS_ID mbx, void *msg, U16 timeout) {
+  void **b = mbx;
+  TCB *w;
+
+  host_sync();
+  w = mbx_waiter(mbx, T_MBX_W);
+  if (w != NULL) {
+    w->msg = msg;
+    host_stats.mbx_sent++;
+    make_ready(w, OS_R_MBX);
+    preempt();
+    return OS_R_OK;
+  }
+  if (MBX_CNT(b) < MBX_CAP(b)) {
+    mbx_put(b, msg);
+    host_stats.mbx_sent++;
+    return OS_R_OK;
+  }
+  host_stats.mbx_full++;
+  if (timeout == 0) return OS_R_TMO;
+  cur->obj = mbx;
+  cur->msg = msg;
+  return block(T_MBX_S, timeout);
+}
+
+OS_RESULT os_mbx_wait(OS_ID mbx, void **msg, U16 timeout) {
+  void **b = mbx;
+  TCB *s;
+  OS_RESULT r;
+
+  host_sync();
+  if (MBX_CNT(b) > 0) {
+    *msg = mbx_get(b);
+    host_stats.mbx_recv++;
+    s = mbx_waiter(mbx, T_MBX_S);
+    if (s != NULL) {
+      mbx_put(b, s->msg);
+      host_stats.mbx_sent++;
+      make_ready(s, OS_R_OK);
+      preempt();
+    }
+    return OS_R_OK;
+  }
+  if (timeout == 0) return OS_R_TMO;
+  cur->obj = mbx;
+  r = block(T_MBX_W, timeout);
+  if (r == OS_R_MBX) {
+    *msg = cur->msg;
+    host_stats.mbx_recv++;
+  }
+  return r;
+}
+
+/*--------------------------- memory pools ----------------------------------*/
+/* Header: [0] block size, [1] first free block (1-based, 0 = none) */
+
+int _init_box(void *pool, U32 size, U32 bsize) {
+  U32 *p = pool;
+  U32 bs = (bsize + 7) & ~7u;
+  U32 n  = (size - 16) / bs;
+  U32 i;
+
+  p[0] = bs;
+  p[1] = n ? 1 : 0;
+  for (i = 0; i < n; i++) {
+    *(U32 *)((U8 *)(p + 4) + i * bs) = (i + 1 < n) ? i + 2 : 0;
+  }
+  return 0;
+}
+
+void *_alloc_box(void *pool) {
+  U32 *p = pool;
+  U8  *blk;
+
+  if (p[1] == 0) return NULL;
+  blk  = (U8 *)(p + 4) + (p[1] - 1) * p[0];
+  p[1] = *(U32 *)blk;
+  return blk;
+}
+
+int _free_box(void *pool, void *block) {
+  U32 *p = pool;
+  U32 i = (U32)(((U8 *)block - (U8 *)(p + 4)) / p[0]);
+
+  *(U32 *)block = p[1];
+  p[1] = i + 1;
+  return 0;
+}
@@ -1,284 +1,522 @@
-/*----------------------------------------------------------------------------
- *      RL-ARM - Library
- *----------------------------------------------------------------------------
- *      Name:    LCD.C
- *      Purpose: LCD module 2x16 driver for ST7066 controller
- *      Rev.:    V4.20
- *----------------------------------------------------------------------------
- *      This code is part of the RealView Run-Time Library.
- *      Copyright (c) 2004-2011 KEIL - An ARM Company. All rights reserved.
- *---------------------------------------------------------------------------*/
-
-#include <RTL.h>
-#include <LPC23xx.H>                    /* LPC23xx definitions               */
-#include "LCD.h"
-
-#define MCB2300_V1                      /* First version of MCB2300          */
-
-#define IO1DIR     IODIR1
-#define IO1SET     IOSET1
-#define IO1CLR     IOCLR1
-#define IO1PIN     IOPIN1
-
-/* LCD IO definitions */
-#ifdef MCB2300_V1
- #define LCD_E     0xC0000000           /* Enable control pin                */
- #define LCD_RW    0x20000000           /* Read/Write control pin            */
- #define LCD_RS    0x10000000           /* Data/Instruction control          */
- #define LCD_CTRL  0xF0000000           /* Control lines mask                */
- #define LCD_DATA  0x0F000000           /* Data lines mask                   */
-#else
- #define LCD_E     0x80000000           /* Enable control pin                */
- #define LCD_RW    0x20000000           /* Read/Write control pin            */
- #define LCD_RS    0x10000000           /* Data/Instruction control          */
- #define LCD_CTRL  0xB0000000           /* Control lines mask                */
- #define LCD_DATA  0x0F000000           /* Data lines mask                   */
-#endif
-
-/* Local variables */
-static U32 lcd_ptr;
-
-/* 8 user defined characters to be loaded into CGRAM (used for bargraph) */
-static const U8 UserFont[8][8] = {
-  { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },
-  { 0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10 },
-  { 0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18 },
-  { 0x1C,0x1C,0x1C,0x1C,0x1C,0x1C,0x1C,0x1C },
-  { 0x1E,0x1E,0x1E,0x1E,0x1E,0x1E,0x1E,0x1E },
-  { 0x1F,0x1F,0x1F,0x1F,0x1F,0x1F,0x1F,0x1F },
-  { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 },
-  { 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 }
-};
-
-/* Local Function Prototypes */
-static void delay (U32 cnt);
-static void lcd_write (U32 c);
-static void lcd_write_4bit (U32 c);
-static U32  lcd_rd_stat (void);
-static void lcd_wr_cmd (U32 c);
-static void lcd_wr_data (U32 d);
-static void lcd_wait_busy (void);
-
-/*----------------------------------------------------------------------------
- * LCD Driver Interface Functions
- *---------------------------------------------------------------------------*/
-
-
-/*--------------------------- delay -----------------------------------------*/
-
-static void delay (U32 cnt) {
-  /* Delay in while loop cycles. */
-
-  while (cnt--);
-}
-
-
-/*--------------------------- lcd_write_4bit --------------------------------*/
-
-static void lcd_write_4bit (U32 c) {
-  /* Write a 4-bit command to LCD controller. */
-
-  IO1DIR |= LCD_DATA | LCD_CTRL;
-  IO1CLR  = LCD_RW   | LCD_DATA;
-  IO1SET  = (c & 0xF) << 24;
-  IO1SET  = LCD_E;
-  delay (10);
-  IO1CLR  = LCD_E;
-  delay (10);
-}
-
-
-/*--------------------------- lcd_write -------------------------------------*/
-
-static void lcd_write (U32 c) {
-  /* Write data/command to LCD controller. */
-
-  lcd_write_4bit (c >> 4);
-  lcd_write_4bit (c);
-}
-
-
-/*--------------------------- lcd_rd_stat -----------------------------------*/
-
-static U32 lcd_rd_stat (void) {
-  /* Read status of LCD controller (ST7066) */
-  U32 stat;
-
-  IO1DIR &= ~LCD_DATA;
-  IO1CLR  = LCD_RS;
-  IO1SET  = LCD_RW;
-  delay (10);
-  IO1SET  = LCD_E;
-  delay (10);
-  stat    = (IO1PIN >> 20) & 0xF0;
-  IO1CLR  = LCD_E;
-  delay (10);
-  IO1SET  = LCD_E;
-  delay (10);
-  stat   |= (IO1PIN >> 24) & 0xF;
-  IO1CLR  = LCD_E;
-  return (stat);
-}
-
-
-/*--------------------------- lcd_wait_busy ---------------------------------*/
-
-static void lcd_wait_busy (void) {
-  /* Wait until LCD controller (ST7066) is busy. */
-  U32 stat;
-
-  do {
-    stat = lcd_rd_stat ();
-  } while (stat & 0x80);                /* Wait for busy flag                */
-}
-
-
-/*--------------------------- lcd_wr_cmd ------------------------------------*/
-
-static void lcd_wr_cmd (U32 c) {
-  /* Write command to LCD controller. */
-
-  lcd_wait_busy ();
-  IO1CLR = LCD_RS;
-  lcd_write (c);
-}
-
-
-/*--------------------------- lcd_wr_data -----------------------------------*/
-
-static void lcd_wr_data (U32 d) {
-  /* Write data to LCD controller. */
-
-  lcd_wait_busy ();
-  IO1SET = LCD_RS;
-  lcd_write (d);
-}
-
-
-/*--------------------------- LCD_init --------------------------------------*/
-
-void LCD_init (void) {
-  /* Initialize the ST7066 LCD controller to 4-bit mode. */ 
-
-  IO1DIR |= LCD_CTRL | LCD_DATA;
-  IO1CLR  = LCD_RW   | LCD_RS   | LCD_DATA;
-
-  lcd_write_4bit (0x3);                 /* Select 4-bit interface            */
-  delay (100000);
-  lcd_write_4bit (0x3);
-  delay (10000);
-  lcd_write_4bit (0x3);
-  lcd_write_4bit (0x2);
-
-  lcd_wr_cmd (0x28);                    /* 2 lines, 5x8 character matrix     */
-  lcd_wr_cmd (0x0e);                    /* Display ctrl:Disp/Curs/Blnk=ON    */
-  lcd_wr_cmd (0x06);                    /* Entry mode: Move right, no shift  */
-
-  LCD_load ((U8 *)&UserFont, sizeof (UserFont));
-  LCD_cls ();
-}
-
-
-/*--------------------------- LCD_load --------------------------------------*/
-
-void LCD_load (U8 *fp, U32 cnt) {
-  /* Load user-specific characters into CGRAM */
-  U32 i;
-
-  lcd_wr_cmd (0x40);                    /* Set CGRAM address counter to 0    */
-  for (i = 0; i < cnt; i++, fp++)  {
-    lcd_wr_data (*fp);
-  }
-}
-
-/*--------------------------- LCD_gotoxy ------------------------------------*/
-
-void LCD_gotoxy (U32 x, U32 y) {
-  /* Set cursor position on LCD display. Left corner: 1,1, right: 16,2 */
-  U32 c;
-
-  c = --x;
-  if (--y) {
-    c |= 0x40;
-  }
-  lcd_wr_cmd (c | 0x80);
-  lcd_ptr = y*16 + x;
-}
-
-
-/*--------------------------- LCD_cls ---------------------------------------*/
-
-void LCD_cls (void) {
-  /* Clear LCD display, move cursor to home position. */
-
-  lcd_wr_cmd (0x01);
-  LCD_gotoxy (1,1);
-}
-
-
-/*--------------------------- LCD_cur_off------------------------------------*/
-
-void LCD_cur_off (void) {
-  /* Switch off LCD cursor. */
-
-  lcd_wr_cmd (0x0c);
-}
-
-
-/*--------------------------- LCD_on ------ ---------------------------------*/
-
-void LCD_on (void) {
-  /* Switch on LCD and enable cursor. */
-
-  lcd_wr_cmd (0x0e);
-}
-
-
-/*--------------------------- LCD_putc --------------------------------------*/
-
-void LCD_putc (U8 c) { 
-  /* Print a character to LCD at current cursor position. */
-
-  if (lcd_ptr == 16) {
-    lcd_wr_cmd (0xc0);
-  }
-  lcd_wr_data (c);
-  lcd_ptr++;
-}
-
-
-/*--------------------------- LCD_puts --------------------------------------*/
-
-void LCD_puts (U8 *sp) {
-  /* Print a string to LCD display. */
-
-  while (*sp) {
-    LCD_putc (*sp++);
-  }
-}
-
-
-/*--------------------------- LCD_bargraph ----------------------------------*/
-
-void LCD_bargraph (U32 val, U32 size) {
-  /* Print a bargraph to LCD display.  */
-  /* - val:  value 0..100 %            */
-  /* - size: size of bargraph 1..16    */
-  U32 i;
-
-  val = val * size / 20;                /* Display matrix 5 x 8 pixels       */
-  for (i = 0; i < size; i++) {
-    if (val > 5) {
-      LCD_putc (5);
-      val -= 5;
-    }
-    else {
-      LCD_putc (val);
-      break;
-    }
-  }
-}
-
-/*----------------------------------------------------------------------------
- * end of file
- *---------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------
+ *      RL-ARM - Library
+ *----------------------------------------------------------------------------
+ *      Name:    LCD.C
+ *      Purpose: LCD module 2x16 driver for ST7066 controller
+ *      Rev.:    V4.20
+ *----------------------------------------------------------------------------
+ *      This code is part of the RealView Run-Time Library.
+ *      Copyright (c) 2004-2011 KEIL - An ARM Company. All rights reserved.
+ *---------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>                    /* LPC23xx definitions               */
+#include "LCD.h"
+#include <string.h>
+
+#define MCB2300_V1                      /* First version of MCB2300          */
+
+#define IO1DIR     IODIR1
+#define IO1SET     IOSET1
+#define IO1CLR     IOCLR1
+#define IO1PIN     IOPIN1
+
+/* LCD IO definitions */
+#ifdef MCB2300_V1
+ #define LCD_E     0xC0000000           /* Enable control pin                */
+ #define LCD_RW    0x20000000           /* Read/Write control pin            */
+ #define LCD_RS    0x10000000           /* Data/Instruction control          */
+ #define LCD_CTRL  0xF0000000           /* Control lines mask                */
+ #define LCD_DATA  0x0F000000           /* Data lines mask                   */
+#else
+ #define LCD_E     0x80000000           /* Enable control pin                */
+ #define LCD_RW    0x20000000           /* Read/Write control pin            */
+ #define LCD_RS    0x10000000           /* Data/Instruction control          */
+ #define LCD_CTRL  0xB0000000           /* Control lines mask                */
+ #define LCD_DATA  0x0F000000           /* Data lines mask                   */
+#endif
+
+#define LCD_ROWS   2                    /* Display lines                     */
+#define LCD_COLS   16                   /* Characters per line               */
+#define LCD_NOADDR 0xFF                 /* DDRAM address counter unknown     */
+
+/* Transfer engine: Timer 2 match interrupt clocks one nibble phase per    */
+/* period out of the command ring, so no task waits for the controller.   */
+#define LCD_TCLK   12000000             /* Timer 2 clock [Hz]                */
+#define LCD_TPER   20                   /* Engine period [us]                */
+#define LCD_TRV    (LCD_TCLK/1000000*LCD_TPER - 1)
+#define LCD_TIM_   (1 << 26)            /* Timer 2 VIC channel mask          */
+
+#define LCD_QSIZE  64                   /* Command ring entries (power of 2) */
+#define LCD_Q_RS   0x100                /* Entry is data (RS=1)              */
+
+#define LCD_GLYPHS 8                    /* CGRAM character slots             */
+#define LCD_FULL   0xFF                 /* ROM character: all dots on        */
+
+/* Local variables */
+static U32 lcd_ptr;
+
+/* Shadow frame buffer: 'lcd_frame' holds the contents requested by the    */
+/* application, 'lcd_glass' mirrors what the controller is displaying.    */
+/* LCD_flush() sends only the cells in which the two differ.              */
+static U8  lcd_frame[LCD_ROWS][LCD_COLS];
+static U8  lcd_glass[LCD_ROWS][LCD_COLS];
+static U32 lcd_addr;                    /* Controller DDRAM address counter  */
+
+/* Command ring, filled by the tasks and drained by LCD_IRQHandler.       */
+static U16 lcd_q[LCD_QSIZE];
+static volatile U32 lcd_q_in;
+static volatile U32 lcd_q_out;
+static volatile U32 lcd_run;            /* Engine timer is running           */
+static U32 lcd_cur;                     /* Entry being transferred           */
+static U32 lcd_phase;                   /* Nibble phase of 'lcd_cur'         */
+static U32 lcd_hold;                    /* Periods left until not busy       */
+
+/* Glyph cache: the CGRAM slots hold the glyphs used last. A slot is    */
+/* loaded on first use of its glyph (9 ring entries) and reused for the  */
+/* least recently used glyph that is not on the display or in the frame */
+/* buffer. Slots below 'lcd_gfirst' were loaded with LCD_load().          */
+static const U8 *lcd_gtag[LCD_GLYPHS];  /* Glyph in each slot, NULL = none   */
+static U32 lcd_guse[LCD_GLYPHS];        /* 'lcd_gclk' at its last use        */
+static U32 lcd_gclk;
+static U32 lcd_gfirst;
+
+/* Bargraph cells with 1..4 of 5 columns on; empty is ' ', full LCD_FULL */
+static const U8 BarFont[4][8] = {
+  { 0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10 },
+  { 0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18 },
+  { 0x1C,0x1C,0x1C,0x1C,0x1C,0x1C,0x1C,0x1C },
+  { 0x1E,0x1E,0x1E,0x1E,0x1E,0x1E,0x1E,0x1E }
+};
+
+/* Local Function Prototypes */
+static void delay (U32 cnt);
+static void lcd_write (U32 c);
+static void lcd_write_4bit (U32 c);
+static U32  lcd_rd_stat (void);
+static void lcd_wr_cmd (U32 c);
+static void lcd_wait_busy (void);
+static U32  lcd_q_free (void);
+static void lcd_q_put (U32 e);
+static void lcd_q_wait (U32 e);
+__irq void  LCD_IRQHandler (void);
+
+/*----------------------------------------------------------------------------
+ * LCD Driver Interface Functions
+ *---------------------------------------------------------------------------*/
+
+
+/*--------------------------- delay -----------------------------------------*/
+
+static void delay (U32 cnt) {
+  /* Delay in while loop cycles. */
+
+  while (cnt--);
+}
+
+
+/*--------------------------- lcd_write_4bit --------------------------------*/
+
+static void lcd_write_4bit (U32 c) {
+  /* Write a 4-bit command to LCD controller. */
+
+  IO1DIR |= LCD_DATA | LCD_CTRL;
+  IO1CLR  = LCD_RW   | LCD_DATA;
+  IO1SET  = (c & 0xF) << 24;
+  IO1SET  = LCD_E;
+  delay (10);
+  IO1CLR  = LCD_E;
+  delay (10);
+}
+
+
+/*--------------------------- lcd_write -------------------------------------*/
+
+static void lcd_write (U32 c) {
+  /* Write data/command to LCD controller. */
+
+  lcd_write_4bit (c >> 4);
+  lcd_write_4bit (c);
+}
+
+
+/*--------------------------- lcd_rd_stat -----------------------------------*/
+
+static U32 lcd_rd_stat (void) {
+  /* Read status of LCD controller (ST7066) */
+  U32 stat;
+
+  IO1DIR &= ~LCD_DATA;
+  IO1CLR  = LCD_RS;
+  IO1SET  = LCD_RW;
+  delay (10);
+  IO1SET  = LCD_E;
+  delay (10);
+  stat    = (IO1PIN >> 20) & 0xF0;
+  IO1CLR  = LCD_E;
+  delay (10);
+  IO1SET  = LCD_E;
+  delay (10);
+  stat   |= (IO1PIN >> 24) & 0xF;
+  IO1CLR  = LCD_E;
+  return (stat);
+}
+
+
+/*--------------------------- lcd_wait_busy ---------------------------------*/
+
+static void lcd_wait_busy (void) {
+  /* Wait until LCD controller (ST7066) is busy. */
+  U32 stat;
+
+  do {
+    stat = lcd_rd_stat ();
+  } while (stat & 0x80);                /* Wait for busy flag                */
+}
+
+
+/*--------------------------- lcd_wr_cmd ------------------------------------*/
+
+static void lcd_wr_cmd (U32 c) {
+  /* Write command to LCD controller. */
+
+  lcd_wait_busy ();
+  IO1CLR = LCD_RS;
+  lcd_write (c);
+}
+
+
+/*--------------------------- lcd_q_free ------------------------------------*/
+
+static U32 lcd_q_free (void) {
+  /* Number of free entries in the command ring. */
+
+  return (LCD_QSIZE - (lcd_q_in - lcd_q_out));
+}
+
+
+/*--------------------------- lcd_q_put -------------------------------------*/
+
+static void lcd_q_put (U32 e) {
+  /* Queue one entry for the transfer engine, start engine if stopped.    */
+  /* Caller must have checked that the ring is not full.                  */
+
+  lcd_q[lcd_q_in & (LCD_QSIZE - 1)] = e;
+  lcd_q_in++;
+  if (lcd_run == 0) {
+    lcd_run = 1;
+    T2TCR   = 1;                        /* Start engine timer                */
+  }
+}
+
+
+/*--------------------------- lcd_q_wait ------------------------------------*/
+
+static void lcd_q_wait (U32 e) {
+  /* Queue one entry, sleep while the ring is full. */
+
+  while (lcd_q_free () == 0) {
+    os_dly_wait (1);
+  }
+  lcd_q_put (e);
+}
+
+
+/*--------------------------- LCD_IRQHandler --------------------------------*/
+
+__irq void LCD_IRQHandler (void) {
+  /* Transfer engine. Each period performs one phase of a 4-bit transfer: */
+  /* put nibble and raise E, then drop E to latch it. After a byte the    */
+  /* engine holds off until the controller has executed it, so the busy   */
+  /* flag is never polled.                                                */
+
+  T2IR = 1;                             /* Clear MR0 interrupt flag          */
+  switch (lcd_phase) {
+    case 0:
+      if (lcd_hold) {
+        lcd_hold--;
+        break;
+      }
+      if (lcd_q_out == lcd_q_in) {
+        T2TCR   = 2;                    /* Ring empty: stop and reset timer  */
+        lcd_run = 0;
+        break;
+      }
+      lcd_cur = lcd_q[lcd_q_out & (LCD_QSIZE - 1)];
+      lcd_q_out++;
+      if (lcd_cur & LCD_Q_RS) IO1SET = LCD_RS;
+      else                    IO1CLR = LCD_RS;
+      IO1CLR = LCD_DATA;
+      IO1SET = ((lcd_cur >> 4) & 0xF) << 24;
+      IO1SET = LCD_E;
+      lcd_phase = 1;
+      break;
+    case 1:
+      IO1CLR = LCD_E;                   /* Latch high nibble                 */
+      lcd_phase = 2;
+      break;
+    case 2:
+      IO1CLR = LCD_DATA;
+      IO1SET = (lcd_cur & 0xF) << 24;
+      IO1SET = LCD_E;
+      lcd_phase = 3;
+      break;
+    default:
+      IO1CLR = LCD_E;                   /* Latch low nibble                  */
+      lcd_hold  = 1;
+      lcd_phase = 0;
+      break;
+  }
+  VICVectAddr = 0;                      /* Acknowledge Interrupt             */
+}
+
+
+/*--------------------------- LCD_init --------------------------------------*/
+
+void LCD_init (void) {
+  /* Initialize the ST7066 LCD controller to 4-bit mode. CGRAM is loaded */
+  /* on demand, see LCD_glyph().                                          */
+
+  IO1DIR |= LCD_CTRL | LCD_DATA;
+  IO1CLR  = LCD_RW   | LCD_RS   | LCD_DATA;
+
+  lcd_write_4bit (0x3);                 /* Select 4-bit interface            */
+  delay (100000);
+  lcd_write_4bit (0x3);
+  delay (10000);
+  lcd_write_4bit (0x3);
+  lcd_write_4bit (0x2);
+
+  lcd_wr_cmd (0x28);                    /* 2 lines, 5x8 character matrix     */
+  lcd_wr_cmd (0x0e);                    /* Display ctrl:Disp/Curs/Blnk=ON    */
+  lcd_wr_cmd (0x06);                    /* Entry mode: Move right, no shift  */
+
+  lcd_wr_cmd (0x01);                    /* Clear display, address 0          */
+  lcd_wait_busy ();
+  lcd_addr = 0;
+  memset (lcd_glass, ' ', sizeof (lcd_glass));
+  LCD_cls ();
+  memset (lcd_gtag, 0, sizeof (lcd_gtag));
+  lcd_gfirst = 0;
+
+  /* From here on the controller is written by the transfer engine only. */
+  /* The busy polls above left the data lines as inputs.                  */
+  IO1DIR       |= LCD_CTRL | LCD_DATA;
+  IO1CLR        = LCD_RW;
+  lcd_q_in      = lcd_q_out = 0;
+  lcd_phase     = lcd_hold  = 0;
+  lcd_run       = 0;
+  PCONP        |= (1 << 22);            /* Power up Timer 2                  */
+  T2TCR         = 2;                    /* Stop and reset                    */
+  T2MR0         = LCD_TRV;
+  T2MCR         = 3;                    /* Interrupt and Reset on MR0        */
+  VICVectAddr26 = (U32)LCD_IRQHandler;
+  VICVectCntl26 = 15;                   /* Lowest vectored priority          */
+  VICIntEnable  = LCD_TIM_;
+}
+
+
+/*--------------------------- LCD_load --------------------------------------*/
+
+void LCD_load (U8 *fp, U32 cnt) {
+  /* Queue user-specific characters for CGRAM. The slots they fill are    */
+  /* taken out of the glyph cache.                                        */
+  U32 i;
+
+  lcd_q_wait (0x40);                    /* Set CGRAM address counter to 0    */
+  for (i = 0; i < cnt; i++, fp++)  {
+    lcd_q_wait (LCD_Q_RS | *fp);
+  }
+  lcd_addr = LCD_NOADDR;                /* Address counter now in CGRAM      */
+  lcd_gfirst = (cnt + 7) / 8;
+  if (lcd_gfirst > LCD_GLYPHS) lcd_gfirst = LCD_GLYPHS;
+}
+
+
+/*--------------------------- lcd_g_shown -----------------------------------*/
+
+static U32 lcd_g_shown (U32 code, U8 *buf) {
+  /* Number of cells of a frame or glass buffer showing character 'code'. */
+  U32 i, n = 0;
+
+  for (i = 0; i < LCD_ROWS*LCD_COLS; i++) {
+    n += (buf[i] == code);
+  }
+  return (n);
+}
+
+
+/*--------------------------- LCD_glyph -------------------------------------*/
+
+U32 LCD_glyph (const U8 *fp) {
+  /* Character code for the 5x8 glyph 'fp' (8 rows), loading it into a    */
+  /* CGRAM slot if it is not in one. The glyph is known by its address.   */
+  /* The slot reused is the least recently used one not in the frame      */
+  /* buffer, preferably not on the display either (reloading a glyph on   */
+  /* the display changes it there until the next flush). Returns ' ' when */
+  /* every slot is in the frame buffer.                                   */
+  U32 i, slot, best, age, gone;
+
+  lcd_gclk++;
+  for (i = lcd_gfirst; i < LCD_GLYPHS; i++) {
+    if (lcd_gtag[i] == fp) {
+      lcd_guse[i] = lcd_gclk;
+      return (i);
+    }
+  }
+  slot = LCD_GLYPHS;
+  best = 0;
+  for (i = lcd_gfirst; i < LCD_GLYPHS; i++) {
+    if (lcd_gtag[i] != NULL && lcd_g_shown (i, (U8 *)lcd_frame)) continue;
+    gone = (lcd_gtag[i] == NULL || !lcd_g_shown (i, (U8 *)lcd_glass));
+    age  = lcd_gclk - lcd_guse[i] + (gone ? 0x80000000 : 0);
+    if (slot == LCD_GLYPHS || age > best) {
+      slot = i;
+      best = age;
+    }
+  }
+  if (slot == LCD_GLYPHS) return (' ');
+
+  lcd_q_wait (0x40 | (slot << 3));      /* Set CGRAM address of the slot     */
+  for (i = 0; i < 8; i++) {
+    lcd_q_wait (LCD_Q_RS | fp[i]);
+  }
+  lcd_addr = LCD_NOADDR;
+  lcd_gtag[slot] = fp;
+  lcd_guse[slot] = lcd_gclk;
+  return (slot);
+}
+
+/*--------------------------- LCD_gotoxy ------------------------------------*/
+
+void LCD_gotoxy (U32 x, U32 y) {
+  /* Set cursor position in frame buffer. Left corner: 1,1, right: 16,2 */
+
+  lcd_ptr = (y - 1)*LCD_COLS + (x - 1);
+}
+
+
+/*--------------------------- LCD_cls ---------------------------------------*/
+
+void LCD_cls (void) {
+  /* Clear frame buffer, move cursor to home position. */
+
+  memset (lcd_frame, ' ', sizeof (lcd_frame));
+  lcd_ptr = 0;
+}
+
+
+/*--------------------------- LCD_clr_line ----------------------------------*/
+
+void LCD_clr_line (U32 y) {
+  /* Clear one line of the frame buffer, move cursor to its start. */
+
+  memset (lcd_frame[y - 1], ' ', LCD_COLS);
+  lcd_ptr = (y - 1)*LCD_COLS;
+}
+
+
+/*--------------------------- LCD_flush -------------------------------------*/
+
+U32 LCD_flush (void) {
+  /* Queue the frame buffer cells that differ from the display contents.  */
+  /* Runs of unchanged cells are skipped with a DDRAM address jump. Does  */
+  /* not wait: cells that do not fit in the ring stay dirty for the next  */
+  /* flush. Returns 1 if any did.                                         */
+  U32 x, y, addr;
+
+  for (y = 0; y < LCD_ROWS; y++) {
+    for (x = 0; x < LCD_COLS; x++) {
+      if (lcd_frame[y][x] == lcd_glass[y][x]) continue;
+      if (lcd_q_free () < 2) return (1);
+      addr = (y ? 0x40 : 0x00) + x;
+      if (addr != lcd_addr) {
+        lcd_q_put (addr | 0x80);        /* Set DDRAM address                 */
+      }
+      lcd_q_put (LCD_Q_RS | lcd_frame[y][x]);
+      lcd_glass[y][x] = lcd_frame[y][x];
+      lcd_addr = addr + 1;              /* Entry mode increments address     */
+    }
+  }
+  return (0);
+}
+
+
+/*--------------------------- LCD_cur_off------------------------------------*/
+
+void LCD_cur_off (void) {
+  /* Switch off LCD cursor. */
+
+  lcd_q_wait (0x0c);
+}
+
+
+/*--------------------------- LCD_on ------ ---------------------------------*/
+
+void LCD_on (void) {
+  /* Switch on LCD and enable cursor. */
+
+  lcd_q_wait (0x0e);
+}
+
+
+/*--------------------------- LCD_putc --------------------------------------*/
+
+void LCD_putc (U8 c) { 
+  /* Put a character to frame buffer at current cursor position. */
+
+  if (lcd_ptr < LCD_ROWS*LCD_COLS) {
+    ((U8 *)lcd_frame)[lcd_ptr++] = c;   /* Line 1 continues into line 2      */
+  }
+}
+
+
+/*--------------------------- LCD_puts --------------------------------------*/
+
+void LCD_puts (U8 *sp) {
+  /* Put a string to frame buffer. */
+
+  while (*sp) {
+    LCD_putc (*sp++);
+  }
+}
+
+
+/*--------------------------- LCD_barcell -----------------------------------*/
+
+U32 LCD_barcell (U32 cols) {
+  /* Character code for a bargraph cell with 'cols' of 5 columns on.      */
+  /* Only partly filled cells take a CGRAM slot.                          */
+
+  if (cols == 0) return (' ');
+  if (cols >= 5) return (LCD_FULL);
+  return (LCD_glyph (BarFont[cols - 1]));
+}
+
+
+/*--------------------------- LCD_bargraph ----------------------------------*/
+
+void LCD_bargraph (U32 val, U32 size) {
+  /* Print a bargraph to LCD display.  */
+  /* - val:  value 0..100 %            */
+  /* - size: size of bargraph 1..16    */
+  /* Writes all 'size' cells, so it can redraw a bar in place; the next   */
+  /* flush sends only the cells between the old and the new bar end.      */
+  U32 i;
+
+  val = val * size / 20;                /* Display matrix 5 x 8 pixels       */
+  for (i = 0; i < size; i++) {
+    if (val > 5) {
+      LCD_putc (LCD_FULL);
+      val -= 5;
+    }
+    else {
+      LCD_putc (LCD_barcell (val));
+      val = 0;
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
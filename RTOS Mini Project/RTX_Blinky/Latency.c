@@ -0,0 +1,77 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Latency histograms
+ *
+ *  Times come from clk_now(), so resolution is well below one RTX tick.
+ *  A job of a periodic task is released at a multiple of its period
+ *  after the first start; an event driven job is released at the stamp
+ *  given to lat_release(), taken where the event was raised (ADC block
+ *  completion, display request). lat_start() records how late the job
+ *  started, lat_done() its response time and counts a deadline miss
+ *  when the response exceeds the deadline from the task table.
+ *
+ *  Each LAT_TASK has one updater at a time: its task, or the worker
+ *  servicing its sensor (SensTab.c).
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include <stdio.h>
+#include <string.h>
+#include "Clock.h"
+#include "TaskReg.h"
+#include "Latency.h"
+
+/* Add one sample of 'counts' clock counts */
+void lat_add(LAT_HIST *h, U32 counts) {
+  U32 us = counts / CLK_PER_US;
+  U32 k = 0, v;
+
+  for (v = us >> 1; v && k < LAT_BINS - 1; v >>= 1) k++;
+  if (h->bin[k] != 0xFFFF) h->bin[k]++;
+  if (us > h->max) h->max = us;
+  h->cnt++;
+}
+
+/* Clear with period and deadline in ticks; period 0 = event driven */
+void lat_init(LAT_TASK *l, U32 period, U32 deadline) {
+  memset(l, 0, sizeof(*l));
+  l->period   = period   * CLK_PER_TICK;
+  l->deadline = deadline * CLK_PER_TICK;
+}
+
+/* Event driven, with the deadline of 'tid' from the task table */
+void lat_task_init(LAT_TASK *l, OS_TID tid) {
+  TSK_INFO *t = tsk_info(tid);
+
+  lat_init(l, 0, (t == NULL) ? 0 : t->deadline);
+}
+
+/* Event driven job raised at clk_now() time 'stamp' */
+void lat_release(LAT_TASK *l, U32 stamp) {
+  l->rel = stamp;
+}
+
+/* Job starts running */
+void lat_start(LAT_TASK *l) {
+  U32 now = clk_now();
+
+  if (l->period) {
+    /* first job defines the phase */
+    if (l->late.cnt == 0) l->rel = now;
+    else                  l->rel += l->period;
+  }
+  lat_add(&l->late, now - l->rel);
+}
+
+/* Job complete */
+void lat_done(LAT_TASK *l) {
+  U32 t = clk_now() - l->rel;
+
+  lat_add(&l->resp, t);
+  if (l->deadline && t > l->deadline) l->misses++;
+}
+
+/* One LCD line: name, worst response [us], deadline misses */
+void lat_format(const LAT_TASK *l, const char *name, char *buf) {
+  sprintf(buf, "%-4.4s%7u%5u", name, l->resp.max, l->misses);
+}
@@ -0,0 +1,37 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Latency histogram definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+/* log2 buckets in microseconds: bin 0 holds 0..1 us, bin k holds
+   2^k .. 2^(k+1)-1 us, the last bin everything above (>= 0.5 s) */
+#define LAT_BINS        20
+#define LAT_TEXT_LEN    17          /* buffer size for lat_format() */
+
+typedef struct {
+  U32  cnt;
+  U32  max;                         /* [us] */
+  U16  bin[LAT_BINS];               /* saturate at 0xFFFF */
+} LAT_HIST;
+
+/* Release, start and completion times of one task */
+typedef struct {
+  U32  rel;                         /* current release [clock counts] */
+  U32  period;                      /* [clock counts], 0 = event driven */
+  U32  deadline;                    /* [clock counts] */
+  U32  misses;                      /* completions after the deadline */
+  LAT_HIST late;                    /* release -> start */
+  LAT_HIST resp;                    /* release -> completion */
+} LAT_TASK;
+
+extern void lat_add (LAT_HIST *h, U32 counts);
+extern void lat_init (LAT_TASK *l, U32 period, U32 deadline);
+extern void lat_task_init (LAT_TASK *l, OS_TID tid);
+extern void lat_release (LAT_TASK *l, U32 stamp);
+extern void lat_start (LAT_TASK *l);
+extern void lat_done (LAT_TASK *l);
+extern void lat_format (const LAT_TASK *l, const char *name, char *buf);
+
+#endif
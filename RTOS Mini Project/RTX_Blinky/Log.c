@@ -0,0 +1,128 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Log pipeline
+ *
+ *  Producers take a block from their own _declare_box pool, fill it and
+ *  hand the pointer to the logger through the mailbox; the block is never
+ *  copied and belongs to exactly one task at a time. The logger frees it
+ *  back into the owner's pool after use.
+ *
+ *  The mailbox holds as many entries as there are blocks in all pools, so
+ *  a send cannot fail. When a pool is empty the record is dropped and
+ *  counted in log_dropped[].
+ *
+ *  Records are binary (id, tick, raw values); producers never format
+ *  text. log_format() is only called on the logger side.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "Log.h"
+#include "Trace.h"
+#include "TaskReg.h"
+#include "Health.h"
+#include <stdio.h>
+
+os_mbx_declare(mbx_log, MSGBOX_SIZE);
+
+_declare_box(log_box_temp,  sizeof(LOG_MSG), LOG_SLOTS);
+_declare_box(log_box_light, sizeof(LOG_MSG), LOG_SLOTS);
+_declare_box(log_box_emerg, sizeof(LOG_MSG), LOG_SLOTS);
+_declare_box(log_box_hlth,  sizeof(LOG_MSG), LOG_SLOTS);
+
+static U32 *const log_box[LOG_SRC_CNT] = {
+  log_box_temp, log_box_light, log_box_emerg, log_box_hlth
+};
+static volatile U32 log_dropped[LOG_SRC_CNT];
+
+/* Initialise pools and mailbox (call from init before creating producers) */
+void log_init(void) {
+  _init_box(log_box_temp,  sizeof(log_box_temp),  sizeof(LOG_MSG));
+  _init_box(log_box_light, sizeof(log_box_light), sizeof(LOG_MSG));
+  _init_box(log_box_emerg, sizeof(log_box_emerg), sizeof(LOG_MSG));
+  _init_box(log_box_hlth,  sizeof(log_box_hlth),  sizeof(LOG_MSG));
+  os_mbx_init(&mbx_log, sizeof(mbx_log));
+}
+
+/* Take a free block from the source's pool. Returns NULL, and counts the
+   drop, when all blocks of this source are still queued or being shown. */
+LOG_MSG *log_alloc(U32 src) {
+  LOG_MSG *msg = _alloc_box(log_box[src]);
+
+  if (msg == NULL) {
+    log_dropped[src]++;
+    TRACE(TRC_MBX_DROP, src, log_dropped[src]);
+    return NULL;
+  }
+  msg->src = (U8)src;
+  return msg;
+}
+
+/* Hand a filled block over to the logger. Ownership passes with it. */
+void log_send(LOG_MSG *msg) {
+  if (os_mbx_send(&mbx_log, msg, 0) != OS_R_OK) {
+    /* cannot happen while the mailbox is sized to the pools */
+    log_dropped[msg->src]++;
+    log_free(msg);
+    return;
+  }
+  TRACE(TRC_MBX_SEND, msg->src, msg->id);
+}
+
+/* Allocate, fill and send a record in one call; drops are counted */
+void log_put(U32 src, U32 id, U32 v0, U32 v1) {
+  LOG_MSG *msg = log_alloc(src);
+
+  if (msg == NULL) return;
+  msg->id     = (U8)id;
+  msg->time   = os_time_get();
+  msg->val[0] = (U16)v0;
+  msg->val[1] = (U16)v1;
+  log_send(msg);
+}
+
+/* Wait for the next message (logger side). Returns NULL on timeout. */
+LOG_MSG *log_wait(U16 timeout) {
+  void *msg;
+
+  if (os_mbx_wait(&mbx_log, &msg, timeout) == OS_R_TMO) return NULL;
+  return (LOG_MSG *)msg;
+}
+
+/* Return a block to its owner's pool */
+void log_free(LOG_MSG *msg) {
+  _free_box(log_box[msg->src], msg);
+}
+
+/* Number of messages dropped for a source since reset */
+U32 log_drops(U32 src) {
+  return log_dropped[src];
+}
+
+#if (LOG_TEXT)
+/* Render a record as display text (buf must hold LOG_TEXT_LEN chars) */
+void log_format(const LOG_MSG *msg, char *buf) {
+  const TSK_INFO *t;
+
+  switch (msg->id) {
+    case LOG_ID_TEMP:
+      sprintf(buf, "Temp:%uC Fan:%u", msg->val[0], msg->val[1]);
+      break;
+    case LOG_ID_LIGHT:
+      sprintf(buf, "Light:%u Level:%u", msg->val[0], msg->val[1]);
+      break;
+    case LOG_ID_OVERHEAT:
+      sprintf(buf, "%s:%uC", msg->val[1] ? "Overheat" : "Cooled", msg->val[0]);
+      break;
+    case LOG_ID_BOOT:
+      sprintf(buf, "Boot:%u%s", msg->val[0],
+              (msg->val[1] & HB_RST_WDT) ? " wdt" : "");
+      break;
+    case LOG_ID_STALL:
+      t = tsk_info(msg->val[0]);
+      sprintf(buf, "Stall:%.7s %u", (t && t->name) ? t->name : "?", msg->val[1]);
+      break;
+    default:
+      sprintf(buf, "?%u %u %u", msg->id, msg->val[0], msg->val[1]);
+      break;
+  }
+}
+#endif
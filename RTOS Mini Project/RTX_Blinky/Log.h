@@ -0,0 +1,55 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Log pipeline definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __LOG_H
+#define __LOG_H
+
+#include "Config.h"                 /* LOG_TEXT, CFG_LOG_SLOTS */
+
+/* Log sources. Every source owns its own fixed-block pool, so a busy
+   producer can only exhaust its own slots. */
+#define LOG_SRC_TEMP    0
+#define LOG_SRC_LIGHT   1
+#define LOG_SRC_EMERG   2
+#define LOG_SRC_HEALTH  3
+#define LOG_SRC_CNT     4
+#define LOG_SRC_SYS     LOG_SRC_CNT /* no pool: written by Flog.c itself */
+
+#define LOG_SLOTS       CFG_LOG_SLOTS /* blocks per source */
+#define MSGBOX_SIZE     (LOG_SRC_CNT * LOG_SLOTS)
+
+/* Record ids, each with its own text format in log_format() */
+#define LOG_ID_TEMP     1           /* val[0]=temp C,  val[1]=fan level   */
+#define LOG_ID_LIGHT    2           /* val[0]=light %, val[1]=light level */
+#define LOG_ID_OVERHEAT 3           /* val[0]=temp C,  val[1]=1 hot, 0 cooled */
+#define LOG_ID_BOOT     4           /* val[0]=boot count, val[1]=reset source
+                                       (RSIR; flash log only) */
+#define LOG_ID_STALL    5           /* val[0]=task id, val[1]=ticks since beat */
+#define LOG_ID_TIME     6           /* val[0..1]=ticks since boot, low/high
+                                       half (flash log only) */
+
+#define LOG_TEXT_LEN    24          /* buffer size for log_format() */
+
+/* Binary log record (8 bytes). Producers store raw values only; the text
+   is produced by the logger, or by a host tool from a record dump. */
+typedef struct {
+  U8   src;                         /* owner pool, see LOG_SRC_xxx */
+  U8   id;                          /* LOG_ID_xxx */
+  U16  time;                        /* os_time_get() at creation; wraps
+                                       every 655 s, see Flog.h */
+  U16  val[2];
+} LOG_MSG;
+
+extern void     log_init (void);
+extern LOG_MSG *log_alloc (U32 src);
+extern void     log_send (LOG_MSG *msg);
+extern void     log_put (U32 src, U32 id, U32 v0, U32 v1);
+extern LOG_MSG *log_wait (U16 timeout);
+extern void     log_free (LOG_MSG *msg);
+extern U32      log_drops (U32 src);
+#if (LOG_TEXT)
+extern void     log_format (const LOG_MSG *msg, char *buf);
+#endif
+
+#endif
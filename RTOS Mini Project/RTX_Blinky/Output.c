@@ -0,0 +1,74 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - LED output manager
+ *
+ *  Each owner keeps the bits it drives (claim) and their desired state.
+ *  out_set() merges all owners in precedence order and stores the result
+ *  to the port with a single masked FIO2PIN write, and only when it
+ *  differs from what the port already shows. Owners never touch each
+ *  other's bits, so no locking is needed around LED updates, and an
+ *  override (motion or overheat flash) restores the lower owners' state
+ *  when it is released. The merge runs with the tick and the wheel
+ *  interrupt masked at the VIC (VIC_WHEEL), so owners may be tasks or
+ *  timer wheel functions.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Vic.h"
+#include "Output.h"
+
+static U8  out_claim[OUT_CNT];      /* bits driven by each owner */
+static U8  out_val[OUT_CNT];        /* desired state of those bits */
+static U8  out_port;                /* last value written */
+static U32 out_nwr;                 /* port stores, for profiling */
+
+/* Merge all owners and write the port if the value changed.
+   Called with VIC_WHEEL masked. */
+static void out_apply(void) {
+  U32 i, port = 0;
+
+  for (i = 0; i < OUT_CNT; i++) {
+    port = (port & ~out_claim[i]) | (out_val[i] & out_claim[i]);
+  }
+  if (port != out_port) {
+    out_port = (U8)port;
+    FIO2PIN  = port;                /* FIO2MASK limits this to OUT_PINS */
+    out_nwr++;
+  }
+}
+
+/* Configure P2.0 - P2.7 as outputs, all LEDs off */
+void out_init(void) {
+  U32 i;
+
+  for (i = 0; i < OUT_CNT; i++) {
+    out_claim[i] = 0;
+    out_val[i]   = 0;
+  }
+  FIO2DIR |= OUT_PINS;
+  FIO2MASK = ~OUT_PINS;             /* FIO2PIN stores reach the LEDs only */
+  FIO2PIN  = 0;
+  out_port = 0;
+  out_nwr  = 0;
+}
+
+/* Claim 'mask' for owner and set those bits to 'value' */
+void out_set(U32 owner, U32 mask, U32 value) {
+  U32 was;
+
+  was = vic_lock(VIC_WHEEL);
+  out_claim[owner] = (U8)(mask & OUT_PINS);
+  out_val[owner]   = (U8)(value & mask);
+  out_apply();
+  vic_unlock(was);
+}
+
+/* Drop all claims of owner; lower owners show through again */
+void out_release(U32 owner) {
+  out_set(owner, 0, 0);
+}
+
+/* Number of port stores since out_init */
+U32 out_writes(void) {
+  return out_nwr;
+}
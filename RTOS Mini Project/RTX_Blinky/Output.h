@@ -0,0 +1,24 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - LED output manager definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __OUTPUT_H
+#define __OUTPUT_H
+
+/* Owners, lowest to highest precedence. A bit claimed by a higher owner
+   overrides the same bit of every lower owner. */
+#define OUT_FAN         0
+#define OUT_LIGHT       1
+#define OUT_CLOCK       2
+#define OUT_MOTION      3           /* motion flash */
+#define OUT_EMERG       4           /* overheat flash */
+#define OUT_CNT         5
+
+#define OUT_PINS        0xFF        /* P2.0 - P2.7 */
+
+extern void out_init (void);
+extern void out_set (U32 owner, U32 mask, U32 value);
+extern void out_release (U32 owner);
+extern U32  out_writes (void);
+
+#endif
@@ -0,0 +1,131 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Task profiler
+ *
+ *  RTX for ARM7 has no task switch hook, so the profiler samples instead:
+ *  a Timer 1 MR0 match at PROF_HZ asks isr_tsk_get() which task it
+ *  interrupted and charges the sample to that task's registry entry.
+ *
+ *  - run time:     samples per task, against all samples taken
+ *  - switches:     the interrupted task differs from the previous sample
+ *  - longest run:  clk_now() time between two such changes
+ *
+ *  Switch counts and run lengths are seen at sample resolution: a task
+ *  that runs and blocks between two samples is not observed. Round-robin
+ *  slices (OS_ROBINTOUT ticks) are far longer than the sample period.
+ *
+ *  Sampling stops while tickless idle sleeps (prof_sleep/prof_wake from
+ *  the idle demon), or the CPU would wake every sample period; the sleep
+ *  still counts as the samples it would have taken.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include <stdio.h>
+#include "Clock.h"
+#include "TaskReg.h"
+#include "Vic.h"
+#include "Profile.h"
+#include "Trace.h"
+
+#define PROF_PERIOD     (CLK_HZ / PROF_HZ)
+
+static volatile U32 prof_total;     /* all samples */
+
+#if (PROF_ENABLE)
+static OS_TID prof_last;            /* task seen by the previous sample */
+static U32    prof_since;           /* clk_now() when prof_last started */
+static U32    prof_slept;           /* clk_now() when idle went to sleep */
+
+/* Sampling interrupt, MR0 of the Timer 1 interrupt (Clock.c) */
+static void prof_match(void) {
+  U32 now = clk_now();
+  OS_TID tid = isr_tsk_get();
+  TSK_INFO *t;
+
+  T1MR0 += PROF_PERIOD;
+
+  prof_total++;
+  t = tsk_info(tid);
+  if (t != NULL && t->name != NULL) t->prof_samples++;
+  if (tid != prof_last) {
+    t = tsk_info(prof_last);
+    if (t != NULL && now - prof_since > t->prof_run_max) {
+      t->prof_run_max = now - prof_since;
+    }
+    t = tsk_info(tid);
+    if (t != NULL) t->prof_switches++;
+    TRACE(TRC_SWITCH, tid, 0);
+    prof_last  = tid;
+    prof_since = now;
+  }
+}
+#endif
+
+/* Start sampling (call from init after clk_init) */
+void prof_init(void) {
+#if (PROF_ENABLE)
+  prof_reset();
+  T1MR0  = clk_now() + PROF_PERIOD;
+  T1MCR |= 1;                       /* interrupt on MR0, no reset */
+  clk_attach(0, prof_match);
+#endif
+}
+
+/* Tickless idle is about to sleep: no sampling interrupt until
+   prof_wake(). Call from the idle demon. */
+void prof_sleep(void) {
+#if (PROF_ENABLE)
+  U32 was = vic_lock(VIC_TIMER1);
+
+  T1MCR &= ~1;
+  prof_slept = clk_now();
+  vic_unlock(was);
+#endif
+}
+
+/* Back from idle: the sleep counts as samples, sampling resumes */
+void prof_wake(void) {
+#if (PROF_ENABLE)
+  U32 was = vic_lock(VIC_TIMER1);
+  U32 now = clk_now();
+  U32 n   = (now - prof_slept) / PROF_PERIOD;
+
+  prof_total += n;
+  T1MR0  = now + PROF_PERIOD;
+  T1MCR |= 1;
+  vic_unlock(was);
+#endif
+}
+
+/* Clear all profiler counters */
+void prof_reset(void) {
+  U32 tid;
+
+  tsk_lock();
+  for (tid = 0; tid < os_tsk_info_cnt; tid++) {
+    os_tsk_info[tid].prof_samples  = 0;
+    os_tsk_info[tid].prof_switches = 0;
+    os_tsk_info[tid].prof_run_max  = 0;
+  }
+  prof_total = 0;
+  tsk_unlock();
+}
+
+/* CPU load of a task in percent */
+U32 prof_load(OS_TID tid) {
+  TSK_INFO *t = tsk_info(tid);
+
+  if (t == NULL || prof_total == 0) return 0;
+  return t->prof_samples * 100 / prof_total;
+}
+
+/* One LCD line for a task: name, load %, switches, longest run [ms].
+   Returns 0 if the task id is not registered. */
+int prof_format(OS_TID tid, char *buf) {
+  TSK_INFO *t = tsk_info(tid);
+
+  if (t == NULL || t->name == NULL) return 0;
+  sprintf(buf, "%-4.4s%3u%%%5u%3u", t->name, prof_load(tid),
+          t->prof_switches % 100000, t->prof_run_max / (CLK_HZ / 1000) % 1000);
+  return 1;
+}
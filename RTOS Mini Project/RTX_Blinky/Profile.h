@@ -0,0 +1,21 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Task profiler definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include "Config.h"                 /* PROF_ENABLE: 0 removes the sampling
+                                       interrupt */
+#define PROF_HZ         2000        /* sampling rate [Hz] */
+
+#define PROF_TEXT_LEN   17          /* buffer size for prof_format() */
+
+extern void prof_init (void);
+extern void prof_reset (void);
+extern void prof_sleep (void);
+extern void prof_wake (void);
+extern U32  prof_load (OS_TID tid);
+extern int  prof_format (OS_TID tid, char *buf);
+
+#endif
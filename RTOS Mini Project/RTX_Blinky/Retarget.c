@@ -0,0 +1,35 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - printf/scanf retarget to UART0
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <rt_misc.h>
+
+#pragma import(__use_no_semihosting_swi)
+
+extern int sendchar (int ch);       /* Serial.c */
+extern int getkey (void);
+
+struct __FILE { int handle; };
+FILE __stdout;
+FILE __stdin;
+
+int fputc(int ch, FILE *f) {
+  return (sendchar(ch));
+}
+
+int fgetc(FILE *f) {
+  return (sendchar(getkey()));
+}
+
+int ferror(FILE *f) {
+  return EOF;
+}
+
+void _ttywrch(int ch) {
+  sendchar(ch);
+}
+
+void _sys_exit(int return_code) {
+  for (;;);
+}
@@ -0,0 +1,138 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Rule engine
+ *
+ *  The automations are a const RULE table: a condition on one Sensor.c
+ *  value and the actions taken when it becomes true and when it becomes
+ *  false again, on the LEDs (Output.c), the LCD alarm, the log or task
+ *  events. Fan and light LEDs follow the level ids the sensor table
+ *  publishes, the motion flash and the overheat alarm follow the raw
+ *  values; another room is more rows.
+ *
+ *  Rules are edge triggered and evaluated incrementally. rule_start()
+ *  chains the rules of each sensor and takes their state from the
+ *  current values without acting on it. sens_write() calls rule_eval()
+ *  only when a value changes, and rule_eval() only tests the rules of
+ *  that sensor, so rules on inputs that hold steady cost nothing, however
+ *  many rooms they cover. A RULE_CHANGE rule acts on every new value.
+ *
+ *  rule_eval() runs in the task that wrote the value (a sensor worker):
+ *  a sensor has one writer at a time (SensTab.c), so each rule's state
+ *  has one user. Actions may therefore use anything a task may call. A
+ *  pulse ends in the timer wheel interrupt with out_release(); a pulse
+ *  started again while it runs is extended.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "Wheel.h"
+#include "Sensor.h"
+#include "Output.h"
+#include "Log.h"
+#include "Screen.h"
+#include "Rule.h"
+
+static RULE_RUN *rule_head[SENS_CNT];
+static U32 rule_neval;              /* conditions tested */
+static U32 rule_nfire;              /* actions taken */
+
+static int rule_test(const RULE *d, U32 v) {
+  switch (d->op) {
+    case RULE_ABOVE: return v > d->level;
+    case RULE_BELOW: return v < d->level;
+    case RULE_EQUAL: return v == d->level;
+  }
+  return 1;                         /* RULE_CHANGE */
+}
+
+/* Wheel timer: a pulse has run its time */
+static void rule_pulse_end(WHEEL_TMR *t) {
+  RULE_RUN *r = (RULE_RUN *)t->arg;
+
+  out_release(r->pulse);
+}
+
+/* Take one action for rule r on value v; returns 0 for RULE_NOP */
+static U32 rule_do(RULE_RUN *r, const RULE_ACT *a, U32 v) {
+  switch (a->kind) {
+    case RULE_OUT:
+      out_set(a->obj, a->mask, a->bits);
+      break;
+    case RULE_OUT_MAP:
+      out_set(a->obj, a->mask, ((const U8 *)a->ref)[v]);
+      break;
+    case RULE_OUT_PULSE:
+      out_set(a->obj, a->mask, a->bits);
+      r->pulse = a->obj;
+      wheel_start(&r->tmr, a->arg, 0);
+      break;
+    case RULE_OUT_FREE:
+      out_release(a->obj);
+      break;
+    case RULE_EVT:
+      os_evt_set(a->arg, *(const OS_TID *)a->ref);
+      break;
+    case RULE_LOG:
+      log_put(a->obj, a->arg, v, a->bits);
+      break;
+    case RULE_ALARM:
+      scr_alarm((const char *)a->ref);
+      break;
+    default:
+      return 0;
+  }
+  return 1;
+}
+
+/* Take over the table. Call from init after wheel_init and after the
+   tasks named in RULE_EVT actions exist, before any sensor is written. */
+void rule_start(const RULE *tab, RULE_RUN *run, U32 cnt) {
+  RULE_RUN **pp;
+  U32 i;
+
+  for (i = 0; i < SENS_CNT; i++) rule_head[i] = NULL;
+  for (i = 0; i < cnt; i++) {
+    run[i].def   = &tab[i];
+    run[i].next  = NULL;
+    run[i].on    = (U8)rule_test(&tab[i], sens_read(tab[i].sens));
+    run[i].pulse = 0;
+    wheel_tmr_init(&run[i].tmr, rule_pulse_end, &run[i]);
+    /* append: the rules of a sensor act in table order */
+    for (pp = &rule_head[tab[i].sens]; *pp != NULL; pp = &(*pp)->next);
+    *pp = &run[i];
+  }
+}
+
+/* A sensor has a new value (from sens_write()): act on its rules whose
+   condition changed */
+void rule_eval(U32 sens, U32 value) {
+  const RULE *d;
+  RULE_RUN *r;
+  U32 n = 0, f = 0;
+  U8 on;
+
+  for (r = rule_head[sens]; r != NULL; r = r->next) {
+    d = r->def;
+    n++;
+    if (d->op == RULE_CHANGE) {
+      f += rule_do(r, &d->on, value);
+      continue;
+    }
+    on = (U8)rule_test(d, value);
+    if (on == r->on) continue;
+    r->on = on;
+    f += rule_do(r, on ? &d->on : &d->off, value);
+  }
+  if (n == 0) return;
+  tsk_lock();
+  rule_neval += n;
+  rule_nfire += f;
+  tsk_unlock();
+}
+
+/* Conditions tested and actions taken since reset */
+U32 rule_evals(void) {
+  return rule_neval;
+}
+
+U32 rule_fires(void) {
+  return rule_nfire;
+}
@@ -0,0 +1,69 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Rule engine definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __RULE_H
+#define __RULE_H
+
+/* Conditions on the value of one Sensor.c id */
+#define RULE_ABOVE      0           /* value > level */
+#define RULE_BELOW      1           /* value < level */
+#define RULE_EQUAL      2           /* value == level */
+#define RULE_CHANGE     3           /* any new value: 'on' every time */
+
+/* Actions */
+#define RULE_NOP        0
+#define RULE_OUT        1           /* out_set(obj, mask, bits) */
+#define RULE_OUT_MAP    2           /* out_set(obj, mask, map[value]) */
+#define RULE_OUT_PULSE  3           /* RULE_OUT, out_release(obj) arg ticks later */
+#define RULE_OUT_FREE   4           /* out_release(obj) */
+#define RULE_EVT        5           /* os_evt_set(arg, *tid) */
+#define RULE_LOG        6           /* log_put(obj, arg, value, bits) */
+#define RULE_ALARM      7           /* scr_alarm(text), NULL clears it */
+
+typedef struct {
+  U8          kind;                 /* RULE_xxx action */
+  U8          obj;                  /* output owner, log source */
+  U8          mask;                 /* output bits */
+  U8          bits;                 /* output pattern, log val[1] */
+  U16         arg;                  /* event flags, log id, pulse [ticks] */
+  const void *ref;                  /* OS_TID * of the task, U8 map[],
+                                       alarm text */
+} RULE_ACT;
+
+/* Action initialisers for the rule table */
+#define RULE_DO_NOP                 { RULE_NOP,      0,   0,   0,   0,   NULL }
+#define RULE_DO_OUT(o, m, b)        { RULE_OUT,      (o), (m), (b), 0,   NULL }
+#define RULE_DO_MAP(o, m, map)      { RULE_OUT_MAP,  (o), (m), 0,   0,   (map) }
+#define RULE_DO_PULSE(o, m, b, t)   { RULE_OUT_PULSE,(o), (m), (b), (t), NULL }
+#define RULE_DO_FREE(o)             { RULE_OUT_FREE, (o), 0,   0,   0,   NULL }
+#define RULE_DO_EVT(tid, f)         { RULE_EVT,      0,   0,   0,   (f), &(tid) }
+#define RULE_DO_LOG(src, id, v1)    { RULE_LOG,      (src), 0, (v1), (id), NULL }
+#define RULE_DO_ALARM(text)         { RULE_ALARM,    0,   0,   0,   0,   (text) }
+
+/* One rule: 'on' when the condition becomes true, 'off' when it becomes
+   false again */
+typedef struct {
+  U8       sens;                    /* Sensor.c id */
+  U8       op;                      /* RULE_ABOVE ... */
+  U16      level;
+  RULE_ACT on;
+  RULE_ACT off;
+} RULE;
+
+/* Run state of one rule, one per table entry, allocated by the caller */
+typedef struct rule_run RULE_RUN;
+struct rule_run {
+  WHEEL_TMR   tmr;                  /* RULE_OUT_PULSE */
+  const RULE *def;
+  RULE_RUN   *next;                 /* next rule on the same sensor */
+  U8          on;                   /* condition held at the last value */
+  U8          pulse;                /* owner released when tmr expires */
+};
+
+extern void rule_start (const RULE *tab, RULE_RUN *run, U32 cnt);
+extern void rule_eval (U32 sens, U32 value);
+extern U32  rule_evals (void);
+extern U32  rule_fires (void);
+
+#endif
@@ -0,0 +1,34 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Task table
+ *
+ *  Creates the tasks of a TASK_DEF table with deadline-monotonic
+ *  priorities: the shorter the deadline, the higher the priority. Equal
+ *  deadlines keep table order (earlier = higher).
+ *
+ *  Every task is event driven. Periodic work runs from the timer wheel
+ *  (Wheel.c), so a task has a deadline but no period.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "TaskReg.h"
+#include "Sched.h"
+
+/* Create all tasks of tab. Call with the caller's priority above all of
+   them, the ids are valid once this returns. */
+void sched_start(const TASK_DEF *tab, U32 cnt) {
+  U32 i, j, prio;
+  TSK_INFO *t;
+
+  for (i = 0; i < cnt; i++) {
+    /* one above every task that ranks lower */
+    prio = 1;
+    for (j = 0; j < cnt; j++) {
+      if (tab[j].deadline > tab[i].deadline ||
+          (tab[j].deadline == tab[i].deadline && j > i)) prio++;
+    }
+    *tab[i].tid = tsk_create(tab[i].func, tab[i].name, prio,
+                             tab[i].stk, tab[i].stk_size);
+    t = tsk_info(*tab[i].tid);
+    if (t != NULL) t->deadline = tab[i].deadline;
+  }
+}
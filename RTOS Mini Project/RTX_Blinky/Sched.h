@@ -0,0 +1,30 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Task table definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __SCHED_H
+#define __SCHED_H
+
+/* One entry per application task */
+typedef struct {
+  FUNCP       func;
+  const char *name;
+  U16         deadline;             /* relative deadline [ticks] */
+  U16         stk_size;             /* stack [bytes], multiple of 8 */
+  U64        *stk;
+  OS_TID     *tid;                  /* receives the task id */
+} TASK_DEF;
+
+/* Expanders for a table macro of the form
+     #define TASKS(X)  X(name, func, deadline, stack) ...
+   TASKS(SCHED_TID) declares OS_TID t_<name>, TASKS(SCHED_STK) the stacks,
+   TASKS(SCHED_PROTO) the task functions and TASKS(SCHED_DEF) the
+   initialisers of a TASK_DEF array. */
+#define SCHED_TID(n, f, d, s)     OS_TID t_##n;
+#define SCHED_STK(n, f, d, s)     static U64 stk_##n[(s) / 8];
+#define SCHED_PROTO(n, f, d, s)   __task void f (void);
+#define SCHED_DEF(n, f, d, s)     { f, #n, d, s, stk_##n, &t_##n },
+
+extern void sched_start (const TASK_DEF *tab, U32 cnt);
+
+#endif
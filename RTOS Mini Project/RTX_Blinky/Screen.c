@@ -0,0 +1,152 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - LCD server
+ *
+ *  One task owns the LCD; every other task posts what it wants shown and
+ *  returns at once, so no client waits for the display or for another
+ *  client. A request is a line of text, not a queued frame: the server
+ *  keeps the latest text of each line and draws whatever is current when
+ *  it runs, so requests posted while it waits collapse into one frame.
+ *
+ *  There are two layers. Normal lines (sensor status, the last log
+ *  record, the INT0 pages) are collected for SCR_BATCH ticks after the
+ *  first request, then drawn together. The alarm covers the whole
+ *  screen while it is set: it wakes the server at once, cuts a batch
+ *  short, and normal requests posted meanwhile only update the lines
+ *  shown when it is cleared. The server runs just below emergency_task
+ *  and only copies text to the LCD frame buffer (LCD_flush() queues the
+ *  changed cells for the Timer 2 engine and does not wait), so the alarm
+ *  reaches the glass within one command ring of transfers, about 6 ms.
+ *  Cells that did not fit in the ring are flushed on the next tick.
+ *
+ *  Text may hold the SCR_G_xxx characters: bar cells from scr_bar() and
+ *  icons, drawn from the CGRAM glyph cache in LCD.c. A bar redrawn at
+ *  sensor rate costs the cells between its old and its new end, and an
+ *  icon costs a slot load only when it was not among the glyphs used
+ *  last.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "LCD.h"
+#include "Trace.h"
+#include "Health.h"
+#include "Screen.h"
+
+static char   scr_text[2][SCR_COLS + 1];  /* normal lines, latest wins */
+static char   scr_alm[SCR_COLS + 1];
+static U8     scr_alm_on;
+static OS_TID scr_tid;
+static U32    scr_nposts;
+static U32    scr_nframes;
+
+/* Icons for SCR_G_FAN.. (5x8, one byte per row) */
+static const U8 scr_icon[SCR_G_END - SCR_G_FAN][8] = {
+  { 0x00,0x19,0x0B,0x04,0x1A,0x13,0x00,0x00 },  /* fan */
+  { 0x0E,0x11,0x11,0x11,0x0A,0x0E,0x0E,0x00 },  /* bulb */
+  { 0x04,0x0E,0x0E,0x0E,0x1F,0x00,0x04,0x00 }   /* bell */
+};
+
+/* Copy at most SCR_COLS characters */
+static void scr_copy(char *dst, const char *src) {
+  U32 i;
+
+  for (i = 0; i < SCR_COLS && src[i]; i++) dst[i] = src[i];
+  dst[i] = 0;
+}
+
+/* Put text into the LCD frame buffer, glyph characters as CGRAM codes */
+static void scr_draw(const char *s) {
+  U32 c;
+
+  for (; *s; s++) {
+    c = (U8)*s;
+    if (c >= SCR_G_FAN && c < SCR_G_END) c = LCD_glyph(scr_icon[c - SCR_G_FAN]);
+    else if (c > 0x80 && c < SCR_G_FAN)  c = LCD_barcell(c - 0x80);
+    LCD_putc((U8)c);
+  }
+}
+
+static void scr_wake(U16 evt) {
+  TRACE(TRC_SCR_POST, evt, os_tsk_self());
+  if (scr_tid) os_evt_set(evt, scr_tid);
+}
+
+/* Bar of 'size' cells for val out of max at dst, terminated; returns
+   the end */
+char *scr_bar(char *dst, U32 val, U32 max, U32 size) {
+  U32 cols = (val >= max) ? size * 5 : val * size * 5 / max;
+  U32 i, n;
+
+  for (i = 0; i < size; i++) {
+    n = (cols > 5) ? 5 : cols;
+    cols -= n;
+    *dst++ = (n == 5) ? (char)0xFF : (n == 0) ? ' ' : (char)SCR_G_BAR(n);
+  }
+  *dst = 0;
+  return dst;
+}
+
+/* Show 'text' on line y (1 or 2) */
+void scr_line(U32 y, const char *text) {
+  tsk_lock();
+  scr_copy(scr_text[y - 1], text);
+  scr_nposts++;
+  tsk_unlock();
+  scr_wake(SCR_EVT_POST);
+}
+
+/* Cover the screen with 'text' on line 1; NULL clears the alarm */
+void scr_alarm(const char *text) {
+  tsk_lock();
+  scr_alm_on = (text != NULL);
+  if (text) scr_copy(scr_alm, text);
+  scr_nposts++;
+  tsk_unlock();
+  scr_wake(SCR_EVT_ALARM);
+}
+
+/* Requests posted and frames drawn since reset */
+U32 scr_posts(void) {
+  return scr_nposts;
+}
+
+U32 scr_frames(void) {
+  return scr_nframes;
+}
+
+/* Server task; create exactly one */
+__task void scr_server(void) {
+  OS_TID self = os_tsk_self();
+  char text[2][SCR_COLS + 1];
+  U32 left = 0;
+  U32 alarm;
+
+  scr_tid = self;
+  for (;;) {
+    hb_park();
+    if (os_evt_wait_or(SCR_EVT_POST | SCR_EVT_ALARM,
+                       left ? 1 : 0xffff) == OS_R_TMO) {
+      hb_beat();
+      left = LCD_flush();
+      continue;
+    }
+    hb_beat();
+    if (!(os_evt_get() & SCR_EVT_ALARM)) {
+      os_evt_wait_or(SCR_EVT_ALARM, SCR_BATCH);
+    }
+    os_evt_clr(SCR_EVT_POST | SCR_EVT_ALARM, self);
+
+    /* copy out: a glyph load may wait for room in the command ring */
+    tsk_lock();
+    alarm = scr_alm_on;
+    scr_copy(text[0], alarm ? scr_alm : scr_text[0]);
+    scr_copy(text[1], alarm ? "" : scr_text[1]);
+    scr_nframes++;
+    tsk_unlock();
+    LCD_cls();
+    scr_draw(text[0]);
+    LCD_gotoxy(1, 2);
+    scr_draw(text[1]);
+    left = LCD_flush();
+    TRACE(TRC_SCR_DRAW, alarm, left);
+  }
+}
@@ -0,0 +1,32 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - LCD server definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __SCREEN_H
+#define __SCREEN_H
+
+#define SCR_COLS        16          /* characters per line */
+#define SCR_BATCH       2           /* ticks to collect normal requests */
+
+/* Characters of posted text drawn from CGRAM glyphs (LCD_glyph()) */
+#define SCR_G_BAR(n)    (0x80 + (n))  /* bar cell, n = 1..4 of 5 columns */
+#define SCR_G_FAN       0x85
+#define SCR_G_BULB      0x86
+#define SCR_G_BELL      0x87
+#define SCR_G_END       0x88
+#define SCR_FAN         "\x85"       /* the same, for string literals */
+#define SCR_BULB        "\x86"
+#define SCR_BELL        "\x87"
+
+/* Server task event flags */
+#define SCR_EVT_POST    0x0001      /* normal line posted */
+#define SCR_EVT_ALARM   0x0002      /* alarm set or cleared */
+
+extern char *scr_bar (char *dst, U32 val, U32 max, U32 size);
+extern void scr_line (U32 y, const char *text);
+extern void scr_alarm (const char *text);
+extern U32  scr_posts (void);
+extern U32  scr_frames (void);
+extern __task void scr_server (void);
+
+#endif
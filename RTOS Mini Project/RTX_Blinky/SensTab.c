@@ -0,0 +1,324 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Table-driven sensors
+ *
+ *  Every sensor of every room is a row in a const STAB_DEF table: where
+ *  its samples come from, how often, how they are filtered and mapped to
+ *  levels, which history series and log source they drive, and the
+ *  Sensor.c ids the value and the level are published under (outputs
+ *  follow those through the rules, Rule.c). A small pool of
+ *  identical worker tasks services the whole table, so adding a sensor
+ *  costs one table row and one STAB_RUN (40 bytes) instead of a task
+ *  with its own stack.
+ *
+ *  Releases come from two places. Sensors with a period sit on the
+ *  timer wheel (Wheel.c), whose interrupt queues them; sensors with
+ *  period 0 are released by every ADC block, signalled to the worker
+ *  attached with adc_attach(). A release queues the sensor and wakes one
+ *  idle worker. A sensor is queued at most once: a release that finds it
+ *  still queued or in service is dropped, so a sensor is never serviced
+ *  by two workers at once and its filter, levels and LAT_TASK have one
+ *  user at a time. The queue is shared with the wheel interrupt and
+ *  guarded by masking it and the tick at the VIC (VIC_WHEEL); the ADC
+ *  interrupt only signals a worker and never touches it.
+ *
+ *  A sensor with back_max set runs at an adaptive rate. Every value
+ *  within dband of the value at its last movement doubles its period
+ *  (for an ADC-paced sensor: the ADC blocks between releases), up to
+ *  2^back_max times the base period; a movement, or stab_kick() for its
+ *  room, brings it back to the base period at once. A quiet house then
+ *  costs a fraction of the jobs and telemetry samples. While every
+ *  ADC-paced sensor is backed off the ADC is paced down to the least
+ *  backed-off one (adc_pace()), so the scans, ADC interrupts and worker
+ *  wakeups back off with it; a block then spans several base periods.
+ *  History keeps its time base: every release adds the base periods it
+ *  stands for, a kick the ones it cuts short, and a publish turns them
+ *  into samples of the new value.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Clock.h"
+#include "Adc.h"
+#include "Filter.h"
+#include "Latency.h"
+#include "Wheel.h"
+#include "Vic.h"
+#include "Sensor.h"
+#include "History.h"
+#include "Log.h"
+#include "Health.h"
+#include "SensTab.h"
+
+static const STAB_DEF *stab_tab;
+static STAB_RUN *stab_run;
+static U32       stab_cnt;
+static STAB_RUN *stab_head;         /* job queue, FIFO */
+static STAB_RUN *stab_tail;
+static OS_TID    stab_tid[STAB_WORKERS];
+static U8        stab_idle[STAB_WORKERS];
+static U32       stab_nwk;          /* registered workers */
+static U32       stab_adc_at;       /* adc_stamp() of the previous block */
+
+#define STAB_BLK_CLK    (CLK_HZ / ADC_HZ * ADC_BLK)  /* block at full pace */
+
+/* Queue a sensor for a release standing for 'span' base periods unless
+   it is queued already; returns the idle worker to wake, 0 if none */
+static OS_TID stab_post(STAB_RUN *r, U32 span) {
+  OS_TID tid = 0;
+  U32 i, was;
+
+  was = vic_lock(VIC_WHEEL);
+  if (!r->queued) {
+    r->queued = 1;
+    r->span   = (U16)span;
+    r->next   = NULL;
+    if (stab_tail) stab_tail->next = r;
+    else           stab_head       = r;
+    stab_tail = r;
+    for (i = 0; i < stab_nwk; i++) {
+      if (stab_idle[i]) {
+        stab_idle[i] = 0;
+        tid = stab_tid[i];
+        break;
+      }
+    }
+  }
+  vic_unlock(was);
+  return tid;
+}
+
+/* Next queued sensor; marks worker w idle when there is none */
+static STAB_RUN *stab_get(U32 w) {
+  STAB_RUN *r;
+  U32 was;
+
+  was = vic_lock(VIC_WHEEL);
+  r = stab_head;
+  if (r != NULL) {
+    stab_head = r->next;
+    if (stab_head == NULL) stab_tail = NULL;
+  } else {
+    stab_idle[w] = 1;
+  }
+  vic_unlock(was);
+  return r;
+}
+
+/* Wheel timer of a periodic sensor, in the wheel interrupt */
+static void stab_due(WHEEL_TMR *t) {
+  STAB_RUN *r = t->arg;
+  OS_TID tid;
+
+  r->rel = clk_now();
+  tid = stab_post(r, 1u << r->back);
+  if (tid) isr_evt_set(STAB_EVT_JOB, tid);
+}
+
+/* ADC block ready: release every sensor paced by the ADC that is not
+   backed off past this block. A block counts the base periods it took,
+   which also covers one that ran partly at an old pace. */
+static void stab_adc_post(void) {
+  U32 rel = adc_stamp();
+  U32 blks = (rel - stab_adc_at + STAB_BLK_CLK / 2) / STAB_BLK_CLK;
+  STAB_RUN *r;
+  OS_TID tid;
+  U32 i, span, n = 0;
+
+  stab_adc_at = rel;
+  if (blks == 0) blks = 1;
+  for (i = 0; i < stab_cnt; i++) {
+    r = &stab_run[i];
+    if (r->def->period != 0) continue;
+    tsk_lock();
+    span = r->skip + blks;
+    tid  = (span >= (1u << r->back));
+    r->skip = tid ? 0 : (U8)span;
+    tsk_unlock();
+    if (!tid) continue;
+    n++;
+    r->rel = rel;
+    tid = stab_post(r, span);
+    if (tid) os_evt_set(STAB_EVT_JOB, tid);
+  }
+  if (n == 0) adc_block();          /* skipped on purpose, not an overrun */
+}
+
+/* Pace the ADC to the least backed-off sensor it releases. Called with
+   the task switch locked. */
+static void stab_pace(void) {
+  U32 i, pace = ~0u;
+
+  for (i = 0; i < stab_cnt; i++) {
+    if (stab_run[i].def->period == 0 && stab_run[i].back < pace) {
+      pace = stab_run[i].back;
+    }
+  }
+  if (pace != ~0u) adc_pace(pace);
+}
+
+/* Set the period to 2^back base periods. Called with the task switch
+   locked. */
+static void stab_rate(STAB_RUN *r, U32 back) {
+  const STAB_DEF *d = r->def;
+
+  if (back == r->back) return;
+  r->back = (U8)back;
+  r->skip = 0;
+  if (d->period) wheel_start(&r->tmr, d->period << back, d->period << back);
+  else           stab_pace();
+}
+
+/* Adaptive rate after a new value: back off while it stays within the
+   deadband of the last movement, snap back when it leaves it */
+static void stab_adapt(STAB_RUN *r, U32 v) {
+  const STAB_DEF *d = r->def;
+  U32 dv = (v > r->ref) ? v - r->ref : r->ref - v;
+
+  tsk_lock();
+  if (r->value == ~0u || dv > d->dband) {
+    r->ref = v;
+    stab_rate(r, 0);
+  } else if (r->back < d->back_max) {
+    stab_rate(r, r->back + 1);
+  }
+  tsk_unlock();
+}
+
+/* Default source: the sensor's channel of the last ADC block */
+static int stab_adc(STAB_RUN *r, U32 *value) {
+  const STAB_DEF *d = r->def;
+
+  if (!filt_input(d->filt, adc_block() + d->ch, ADC_NCH, ADC_BLK)) return 0;
+  *value = filt_value(d->filt) * d->scale / 1024;
+  return 1;
+}
+
+/* Base periods per value: the default source needs enough blocks to
+   fill its filter's decimator */
+static U32 stab_per(const STAB_DEF *d) {
+  if (d->read != NULL || d->filt == NULL) return 1;
+  return (d->filt->decim + ADC_BLK - 1) / ADC_BLK;
+}
+
+/* Publish a new value; the level and log follow level changes only */
+static void stab_publish(STAB_RUN *r, U32 v) {
+  const STAB_DEF *d = r->def;
+  int changed;
+  U32 level, n;
+
+  if (d->sens != STAB_NONE) sens_write(d->sens, v);
+  if (d->hist != STAB_NONE) {
+    tsk_lock();
+    n = r->due / stab_per(d);
+    r->due -= (U16)(n * stab_per(d));
+    tsk_unlock();
+    for (; n > 0; n--) hist_add(d->hist, v);
+  }
+  if (d->lvl != NULL) {
+    changed = lvl_update(d->lvl, v);
+    level   = d->lvl->level;
+    if (changed && d->lvl_sens != STAB_NONE) sens_write(d->lvl_sens, level);
+    if (changed && d->log != STAB_NONE) log_put(d->log, d->log_id, v, level);
+  } else {
+    changed = (v != r->value);
+  }
+  if (d->back_max) stab_adapt(r, v);
+  r->value = v;
+  if (d->note) d->note(r, changed);
+}
+
+static void stab_service(STAB_RUN *r) {
+  const STAB_DEF *d = r->def;
+  U32 v;
+  int ok;
+
+  if (d->lat) {
+    lat_release(d->lat, r->rel);
+    lat_start(d->lat);
+  }
+  ok = d->read ? d->read(r, &v) : stab_adc(r, &v);
+  tsk_lock();
+  r->due += r->span;
+  tsk_unlock();
+  if (ok) stab_publish(r, v);
+  if (d->lat) lat_done(d->lat);
+  r->queued = 0;
+}
+
+/* Take over the table and arm the periodic sensors. Call from init
+   after wheel_init and before adc_init, before the workers run. */
+void stab_start(const STAB_DEF *tab, STAB_RUN *run, U32 cnt) {
+  U32 i;
+
+  stab_tab = tab;
+  stab_run = run;
+  stab_cnt = cnt;
+  stab_adc_at = clk_now();          /* the first block is one period on */
+  for (i = 0; i < cnt; i++) {
+    run[i].def    = &tab[i];
+    run[i].next   = NULL;
+    run[i].value  = ~0u;
+    run[i].src    = 0;
+    run[i].ref    = 0;
+    run[i].back   = 0;
+    run[i].skip   = 0;
+    run[i].span   = 1;
+    run[i].due    = 0;
+    run[i].queued = 0;
+    if (tab[i].lat) lat_init(tab[i].lat, 0, tab[i].deadline);
+    wheel_tmr_init(&run[i].tmr, stab_due, &run[i]);
+    if (tab[i].period) wheel_start(&run[i].tmr, tab[i].period, tab[i].period);
+  }
+}
+
+/* Every adaptive sensor of 'room' back to its base period; a periodic
+   one is released on the next tick. The base periods gone by since its
+   last release go to the history with its next publish, so the series
+   keeps one writer. Call from a task, e.g. on motion. */
+void stab_kick(U32 room) {
+  const STAB_DEF *d;
+  STAB_RUN *r;
+  U32 i, was;
+
+  was = vic_lock(VIC_WHEEL);        /* no release comes in between */
+  for (i = 0; i < stab_cnt; i++) {
+    r = &stab_run[i];
+    d = r->def;
+    if (d->room != room || r->back == 0) continue;
+    if (d->period) {
+      r->due  += (U16)((clk_now() - r->rel) /
+                       (d->period * CLK_PER_TICK));
+      wheel_start(&r->tmr, 1, d->period);
+    } else {
+      r->due  += r->skip;
+    }
+    r->back = 0;
+    r->skip = 0;
+  }
+  stab_pace();
+  vic_unlock(was);
+}
+
+/* Worker task; create up to STAB_WORKERS of them */
+__task void stab_worker(void) {
+  STAB_RUN *r;
+  U32 w;
+
+  tsk_lock();
+  w = stab_nwk;
+  if (w < STAB_WORKERS) {
+    stab_tid[w] = os_tsk_self();
+    stab_nwk++;
+  }
+  tsk_unlock();
+  if (w >= STAB_WORKERS) os_tsk_delete_self();
+
+  for (;;) {
+    while ((r = stab_get(w)) != NULL) stab_service(r);
+    hb_park();
+    os_evt_wait_or(STAB_EVT_JOB | STAB_EVT_ADC, 0xffff);
+    hb_beat();
+    stab_idle[w] = 0;
+    if (os_evt_get() & STAB_EVT_ADC) stab_adc_post();
+  }
+}
@@ -0,0 +1,68 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Sensor table definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __SENSTAB_H
+#define __SENSTAB_H
+
+#define STAB_NONE       0xFF        /* unused id/owner/channel field */
+#define STAB_WORKERS    4           /* max. worker tasks */
+
+/* Worker task event flags */
+#define STAB_EVT_JOB    0x0001      /* sensor queued */
+#define STAB_EVT_ADC    0x0002      /* ADC block ready, see adc_attach() */
+
+typedef struct stab_run STAB_RUN;
+
+/* New sample into *value; returns 0 if there is none yet */
+typedef int  (*STAB_READ)(STAB_RUN *r, U32 *value);
+/* Called after every value; 'changed': new level, or new value if the
+   sensor has no levels */
+typedef void (*STAB_NOTE)(STAB_RUN *r, int changed);
+
+/* One sensor. Any field set to STAB_NONE/NULL is skipped. */
+typedef struct {
+  const char *name;
+  U8        room;
+  U8        sens;                   /* Sensor.c id it publishes */
+  U8        ch;                     /* ADC channel */
+  U8        scale;                  /* value at ADC full scale */
+  U16       period;                 /* [ticks], 0 = every ADC block */
+  U16       deadline;               /* release to done [ticks] */
+  FILTER   *filt;                   /* ADC sample filter */
+  LEVELS   *lvl;
+  U8        lvl_sens;               /* Sensor.c id the level is published as */
+  U8        hist;                   /* History series */
+  U8        log;                    /* log source of level changes */
+  U8        log_id;
+  LAT_TASK *lat;
+  STAB_READ read;                   /* NULL = ADC channel through filt */
+  STAB_NOTE note;
+  U8        back_max;               /* adaptive: period up to 2^back_max
+                                       times, 0 = fixed rate */
+  U8        dband;                  /* change that counts as movement */
+} STAB_DEF;
+
+/* Run state of one sensor, one per table entry, allocated by the caller */
+struct stab_run {
+  WHEEL_TMR       tmr;              /* period > 0 */
+  const STAB_DEF *def;
+  STAB_RUN       *next;             /* job queue */
+  U32             rel;              /* clk_now() of the release */
+  U32             value;            /* last value, ~0 before the first */
+  U32             src;              /* free for the read function */
+  U32             ref;              /* value at the last movement */
+  U16             span;             /* base periods the queued release
+                                       stands for */
+  U16             due;              /* base periods not yet in the history */
+  U8              back;             /* period is 2^back base periods */
+  U8              skip;             /* ADC: base periods since the last
+                                       release */
+  U8              queued;           /* queued or being serviced */
+};
+
+extern void stab_start (const STAB_DEF *tab, STAB_RUN *run, U32 cnt);
+extern void stab_kick (U32 room);
+extern __task void stab_worker (void);
+
+#endif
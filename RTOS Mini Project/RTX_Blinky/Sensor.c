@@ -0,0 +1,67 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Sensor state
+ *
+ *  Latest value of every sensor, and of the levels the sensor table
+ *  derives from them. A write that changes a value runs the rules on it
+ *  (Rule.c) in the writing task, so automations and task notifications
+ *  follow value changes instead of tasks polling the values.
+ *
+ *  Readers never block: the state is guarded by a sequence counter that
+ *  is odd while an update is in progress. sens_snapshot() copies the
+ *  values and retries if the counter was odd or changed meanwhile. Each
+ *  field has a single writer at a time (the worker servicing its sensor,
+ *  see SensTab.c); writers of different fields are kept apart by locking
+ *  the task switch for the few stores of an update.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "Wheel.h"
+#include "Sensor.h"
+#include "Rule.h"
+
+static volatile U32 sens_seq;       /* odd while an update is running */
+static volatile U32 sens_val[SENS_CNT];
+static volatile U16 sens_time;
+
+/* Initialise sensor state (call from init before creating tasks) */
+void sens_init(void) {
+  sens_seq = 0;
+  sens_val[SENS_TEMP]   = 20;
+  sens_val[SENS_LIGHT]  = 50;
+  sens_val[SENS_MOTION] = 0;
+  sens_val[SENS_FAN]    = SENS_NONE;
+  sens_val[SENS_LAMP]   = SENS_NONE;
+}
+
+/* Store a new value and run its rules if it changed */
+void sens_write(U32 id, U32 value) {
+  U16 now = os_time_get();
+  U32 old;
+
+  tsk_lock();
+  sens_seq++;
+  old = sens_val[id];
+  sens_val[id] = value;
+  sens_time = now;
+  sens_seq++;
+  tsk_unlock();
+
+  if (old != value) rule_eval(id, value);
+}
+
+/* Latest value of a sensor (a single word needs no sequence check) */
+U32 sens_read(U32 id) {
+  return sens_val[id];
+}
+
+/* Copy all values and the update time as one consistent snapshot */
+void sens_snapshot(SENS_SNAP *snap) {
+  U32 seq;
+  int i;
+
+  do {
+    seq = sens_seq;
+    for (i = 0; i < SENS_CNT; i++) snap->val[i] = sens_val[i];
+    snap->time = sens_time;
+  } while ((seq & 1) || seq != sens_seq);
+}
@@ -0,0 +1,29 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Sensor state definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __SENSOR_H
+#define __SENSOR_H
+
+/* Sensor ids */
+#define SENS_TEMP       0           /* Celsius */
+#define SENS_LIGHT      1           /* 0=bright 100=dark */
+#define SENS_MOTION     2           /* 1 = motion detected */
+#define SENS_FAN        3           /* temperature level 0..3 */
+#define SENS_LAMP       4           /* light level 0..3 */
+#define SENS_CNT        5
+
+#define SENS_NONE       0xFF        /* level before the first value */
+
+/* Consistent copy of all sensor values */
+typedef struct {
+  U32  val[SENS_CNT];
+  U16  time;                        /* os_time_get() of the last update */
+} SENS_SNAP;
+
+extern void sens_init (void);
+extern void sens_write (U32 id, U32 value);
+extern U32  sens_read (U32 id);
+extern void sens_snapshot (SENS_SNAP *snap);
+
+#endif
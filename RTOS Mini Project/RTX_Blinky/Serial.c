@@ -0,0 +1,180 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - UART0
+ *
+ *  Interrupt driven UART0 on P0.2/P0.3 (COM0 of the MCB2300), 115200 8N1
+ *  from the 12 MHz peripheral clock through the fractional divider.
+ *
+ *  Both directions go through rings. Writers only advance the TX head,
+ *  the ISR only the TX tail, so the ISR never waits for a task. On THRE
+ *  the ISR refills the 16 byte FIFO from the ring; a write to an idle
+ *  transmitter primes the FIFO itself. Received bytes are moved to the
+ *  RX ring on RDA/CTI and the attached task gets its event flag.
+ *
+ *  The LPC23xx GPDMA has no UART request lines, so the FIFO refill is
+ *  done by the ISR: one interrupt per 16 bytes, about 720 per second at
+ *  full rate.
+ *
+ *  ser_write() never blocks and returns the number of bytes taken.
+ *  ser_send() and sendchar() (the printf path, see Retarget.c) sleep
+ *  one tick at a time while the ring is full.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Vic.h"
+#include "Serial.h"
+
+/* 12 MHz / (16 * 4 * (1 + 5/8)) = 115385 Baud (+0.16%) */
+#define SER_DL          4
+#define SER_FDR         ((8 << 4) | 5)  /* MULVAL 8, DIVADDVAL 5 */
+#define SER_FIFO        16
+
+#define IER_RBR         0x01
+#define IER_THRE        0x02
+#define LSR_RDR         0x01
+#define LSR_THRE        0x20
+
+static U8  ser_tx[SER_TXBUF];
+static U8  ser_rx[SER_RXBUF];
+static volatile U32 ser_tx_head;    /* written by tasks */
+static volatile U32 ser_tx_tail;    /* written by the ISR */
+static volatile U32 ser_rx_head;    /* written by the ISR */
+static volatile U32 ser_rx_tail;    /* written by ser_getc */
+static volatile U8  ser_tx_busy;    /* THRE interrupt pending */
+static OS_TID ser_tid;
+static U16    ser_evt;
+
+/* Move up to one FIFO load from the TX ring to the UART. A THRE
+   interrupt follows iff anything was written. */
+static void ser_fill(void) {
+  U32 n = 0;
+
+  while (n < SER_FIFO && ser_tx_tail != ser_tx_head) {
+    U0THR = ser_tx[ser_tx_tail & (SER_TXBUF - 1)];
+    ser_tx_tail++;
+    n++;
+  }
+  ser_tx_busy = (n != 0);
+}
+
+static __irq void ser_irq(void) {
+  U32 iir;
+  int rx = 0;
+
+  while (!((iir = U0IIR) & 0x01)) {
+    switch (iir & 0x0E) {
+      case 0x04:                    /* RDA */
+      case 0x0C:                    /* CTI */
+        while (U0LSR & LSR_RDR) {
+          U8 c = U0RBR;
+          if (ser_rx_head - ser_rx_tail < SER_RXBUF) {
+            ser_rx[ser_rx_head & (SER_RXBUF - 1)] = c;
+            ser_rx_head++;
+          }
+          rx = 1;
+        }
+        break;
+      case 0x02:                    /* THRE */
+        ser_fill();
+        break;
+      default:                      /* line status: read to clear */
+        (void)U0LSR;
+        break;
+    }
+  }
+  if (rx && ser_tid) isr_evt_set(ser_evt, ser_tid);
+  VICVectAddr = 0;
+}
+
+/* Set up UART0 and its interrupt */
+void init_serial(void) {
+  PINSEL0 = (PINSEL0 & ~0xF0) | 0x50;   /* TxD0, RxD0 */
+  U0LCR   = 0x83;                       /* 8 bits, no parity, 1 stop, DLAB */
+  U0DLL   = SER_DL & 0xFF;
+  U0DLM   = SER_DL >> 8;
+  U0FDR   = SER_FDR;
+  U0LCR   = 0x03;                       /* DLAB = 0 */
+  U0FCR   = 0x07;                       /* enable and reset FIFOs, RX 1 */
+  VICVectAddr6 = (U32)ser_irq;
+  VICVectCntl6 = 11;
+  VICIntEnable = (1 << 6);
+  U0IER   = IER_RBR | IER_THRE;
+}
+
+/* Wake 'tid' with 'evt' when bytes arrive */
+void ser_attach(OS_TID tid, U16 evt) {
+  ser_evt = evt;
+  ser_tid = tid;
+}
+
+/* Queue up to len bytes without blocking; returns the number taken.
+   Task context only. */
+U32 ser_write(const void *buf, U32 len) {
+  const U8 *p = buf;
+  U32 n, head, was;
+
+  tsk_lock();                         /* one writer at a time */
+  head = ser_tx_head;
+  n    = SER_TXBUF - (head - ser_tx_tail);
+  if (n > len) n = len;
+  len = n;
+  while (n--) {
+    ser_tx[head & (SER_TXBUF - 1)] = *p++;
+    head++;
+  }
+  ser_tx_head = head;
+  tsk_unlock();
+
+  /* idle transmitter: no THRE will come, prime the FIFO here */
+  if (len && !ser_tx_busy) {
+    was = vic_lock(VIC_UART0);
+    if (!ser_tx_busy && (U0LSR & LSR_THRE)) ser_fill();
+    vic_unlock(was);
+  }
+  return len;
+}
+
+/* Queue all of buf, sleeping while the ring is full */
+void ser_send(const void *buf, U32 len) {
+  const U8 *p = buf;
+  U32 n;
+
+  for (;;) {
+    n = ser_write(p, len);
+    p += n;
+    len -= n;
+    if (len == 0) break;
+    os_dly_wait(1);
+  }
+}
+
+/* Free space in the TX ring */
+U32 ser_txfree(void) {
+  return SER_TXBUF - (ser_tx_head - ser_tx_tail);
+}
+
+/* Take a received character, -1 if there is none */
+int ser_getc(void) {
+  int c;
+
+  if (ser_rx_tail == ser_rx_head) return -1;
+  c = ser_rx[ser_rx_tail & (SER_RXBUF - 1)];
+  ser_rx_tail++;
+  return c;
+}
+
+/* printf path: queue one character */
+int sendchar(int ch) {
+  U8 c = (U8)ch;
+
+  ser_send(&c, 1);
+  return ch;
+}
+
+/* Wait for a received character */
+int getkey(void) {
+  int c;
+
+  while ((c = ser_getc()) < 0) os_dly_wait(1);
+  return c;
+}
@@ -0,0 +1,21 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - UART0 definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __SERIAL_H
+#define __SERIAL_H
+
+#define SER_BAUD        115200      /* 8N1 */
+#define SER_TXBUF       512         /* TX ring [bytes], power of 2 */
+#define SER_RXBUF       64          /* RX ring [bytes], power of 2 */
+
+extern void init_serial (void);
+extern void ser_attach (OS_TID tid, U16 evt);
+extern U32  ser_write (const void *buf, U32 len);
+extern void ser_send (const void *buf, U32 len);
+extern int  ser_getc (void);
+extern U32  ser_txfree (void);
+extern int  sendchar (int ch);
+extern int  getkey (void);
+
+#endif
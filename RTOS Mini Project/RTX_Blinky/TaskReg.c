@@ -0,0 +1,57 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Task registry
+ *
+ *  One TSK_INFO slot per RTX task id, so every lookup is a bounds check
+ *  and an index. The ceiling manager and the profiling features keep
+ *  their per-task state here.
+ *
+ *  Tasks created with tsk_create() run on a stack sized by the caller.
+ *  The stack is painted with STK_PAINT first; tsk_stack_used() scans up
+ *  from the bottom for the first overwritten word, which gives the peak
+ *  usage since creation.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <string.h>
+#include "TaskReg.h"
+
+/* Register a task right after os_tsk_create(). Clears any state left in
+   the slot by a previous task with the same id. */
+void tsk_register(OS_TID tid, const char *name, U32 prio) {
+  TSK_INFO *t = tsk_info(tid);
+
+  if (t == NULL) return;
+  memset(t, 0, sizeof(*t));
+  t->name      = name;
+  t->base_prio = (U8)prio;
+  t->prio      = (U8)prio;
+}
+
+/* Paint a user stack, create the task on it and register it */
+OS_TID tsk_create(FUNCP task, const char *name, U32 prio,
+                  U64 *stk, U32 size) {
+  U32 *p = (U32 *)stk;
+  U32 i;
+  OS_TID tid;
+
+  for (i = 0; i < size / 4; i++) p[i] = STK_PAINT;
+  tid = os_tsk_create_user(task, (U8)prio, stk, (U16)size);
+  tsk_register(tid, name, prio);
+  if (tsk_info(tid) != NULL) {
+    tsk_info(tid)->stk      = p;
+    tsk_info(tid)->stk_size = size;
+  }
+  return tid;
+}
+
+/* Peak stack usage of a task in bytes (0 if it has no user stack). The
+   lowest word holds the RTX overflow check pattern and is skipped. */
+U32 tsk_stack_used(OS_TID tid) {
+  TSK_INFO *t = tsk_info(tid);
+  U32 i, n;
+
+  if (t == NULL || t->stk == NULL) return 0;
+  n = t->stk_size / 4;
+  for (i = 1; i < n && t->stk[i] == STK_PAINT; i++);
+  return (n - i) * 4;
+}
@@ -0,0 +1,49 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Task registry definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __TASKREG_H
+#define __TASKREG_H
+
+#define RES_NEST        4           /* resources one task may hold at once */
+
+/* Per-task metadata, indexed directly by the RTX task id. The table is
+   sized from OS_TASKCNT and allocated in RTX_Config.c. */
+typedef struct {
+  const char *name;                 /* NULL = slot not registered */
+  U8   base_prio;                   /* priority given at creation */
+  U8   prio;                        /* current effective priority */
+  U8   ceilings;                    /* ceiling resources currently held */
+  U8   waiting;                     /* blocked in res_lock() */
+  U8   res_prio[RES_NEST];          /* priority to restore per held resource */
+  struct res *res_held[RES_NEST];   /* held resources, oldest first */
+  U32  res_locks;                   /* resources locked */
+  U32  res_blocks;                  /* res_lock() calls that had to block */
+  U32  prof_samples;                /* profiler samples while running */
+  U32  prof_switches;               /* times seen switched in */
+  U32  prof_run_max;                /* longest run seen [clock counts] */
+  U16  deadline;                    /* task table: deadline [ticks] */
+  U32 *stk;                         /* user stack, NULL = system stack */
+  U32  stk_size;                    /* user stack size [bytes] */
+  U16  hb_budget;                   /* heartbeat budget [ticks], 0 = unwatched */
+  U16  hb_last;                     /* os_time_get() of the last beat */
+  U8   hb_parked;                   /* in its main wait: no budget */
+  U8   hb_crit;                     /* late: stop the watchdog feed */
+  U8   hb_late;                     /* monitor: found late, logged */
+  U32  hb_overruns;                 /* times found late */
+} TSK_INFO;
+
+#define STK_PAINT       0xCCCCCCCC  /* fill pattern of unused stack */
+
+extern TSK_INFO     os_tsk_info[];
+extern U32 const    os_tsk_info_cnt;
+
+/* Registry entry of a task id, NULL if the id is out of range */
+#define tsk_info(tid)   (((U32)(tid) < os_tsk_info_cnt) ? &os_tsk_info[tid] : NULL)
+
+extern void tsk_register (OS_TID tid, const char *name, U32 prio);
+extern OS_TID tsk_create (FUNCP task, const char *name, U32 prio,
+                          U64 *stk, U32 size);
+extern U32  tsk_stack_used (OS_TID tid);
+
+#endif
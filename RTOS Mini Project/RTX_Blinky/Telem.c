@@ -0,0 +1,134 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Telemetry frames
+ *
+ *  Batches sensor snapshots into one binary frame (see Telem.h) and sends
+ *  it when TELEM_MAX samples are collected, when TELEM_FLUSH ticks have
+ *  passed since the first one, or when a sample does not fit the delta
+ *  encoding. A sample costs 3 bytes against about 20 for a text line,
+ *  and the 14 bytes of framing are shared by up to 32 samples.
+ *
+ *  Frames go out with the non-blocking ser_write(); a frame that does not
+ *  fit the TX ring is dropped and counted, never waited for. All calls
+ *  come from one task (serial_task), which also owns the other UART
+ *  output, so frames are never interleaved with it.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include "Sensor.h"
+#include "Serial.h"
+#include "Telem.h"
+
+static U8  tlm_buf[TELEM_FRAME];
+static U32 tlm_len;                 /* bytes in tlm_buf, 0 = no frame */
+static U32 tlm_n;                   /* samples in the frame */
+static U16 tlm_seq;
+static U16 tlm_first;               /* os_time_get() of the first sample */
+static U16 tlm_prev;                /* os_time_get() of the last sample */
+static U32 tlm_time;                /* 32 bit tick count */
+static U16 tlm_tick;                /* os_time_get() at the last update */
+static SENS_SNAP tlm_last;
+static U32 tlm_dropped;
+
+/* CRC-16/CCITT, nibble table */
+static const U16 crc_tab[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static U16 crc16(const U8 *p, U32 len) {
+  U16 crc = 0xFFFF;
+
+  while (len--) {
+    crc = (crc << 4) ^ crc_tab[(crc >> 12) ^ (*p >> 4)];
+    crc = (crc << 4) ^ crc_tab[(crc >> 12) ^ (*p & 0x0F)];
+    p++;
+  }
+  return crc;
+}
+
+/* Start a frame with 'snap' as its absolute first sample */
+static void tlm_start(const SENS_SNAP *snap, U16 now) {
+  U32 t = tlm_time;
+
+  tlm_buf[0]  = TELEM_SYNC;
+  tlm_buf[1]  = TELEM_VER;
+  tlm_buf[2]  = (U8)tlm_seq;
+  tlm_buf[3]  = (U8)(tlm_seq >> 8);
+  tlm_buf[4]  = (U8)t;
+  tlm_buf[5]  = (U8)(t >> 8);
+  tlm_buf[6]  = (U8)(t >> 16);
+  tlm_buf[7]  = (U8)(t >> 24);
+  tlm_buf[8]  = 1;
+  tlm_buf[9]  = (U8)snap->val[SENS_TEMP];
+  tlm_buf[10] = (U8)snap->val[SENS_LIGHT];
+  tlm_buf[11] = (U8)snap->val[SENS_MOTION];
+  tlm_len   = TELEM_HDR;
+  tlm_n     = 1;
+  tlm_first = now;
+}
+
+/* Add one snapshot; unchanged values are not sent again */
+void telem_add(const SENS_SNAP *snap) {
+  U16 now = os_time_get();
+  S32 dt, dtemp, dlight;
+
+  tlm_time += (U16)(now - tlm_tick);
+  tlm_tick  = now;
+
+  if (tlm_len != 0 &&
+      snap->val[SENS_TEMP]   == tlm_last.val[SENS_TEMP] &&
+      snap->val[SENS_LIGHT]  == tlm_last.val[SENS_LIGHT] &&
+      snap->val[SENS_MOTION] == tlm_last.val[SENS_MOTION]) return;
+
+  if (tlm_len != 0) {
+    dt     = (U16)(now - tlm_prev);
+    dtemp  = (S32)snap->val[SENS_TEMP]  - (S32)tlm_last.val[SENS_TEMP];
+    dlight = (S32)snap->val[SENS_LIGHT] - (S32)tlm_last.val[SENS_LIGHT];
+    if (dt > 255 || dtemp < -128 || dtemp > 127 ||
+        dlight < -64 || dlight > 63) {
+      telem_flush();
+    } else {
+      tlm_buf[tlm_len++] = (U8)dt;
+      tlm_buf[tlm_len++] = (U8)dtemp;
+      tlm_buf[tlm_len++] = (U8)((dlight << 1) | (snap->val[SENS_MOTION] & 1));
+      tlm_n++;
+    }
+  }
+  if (tlm_len == 0) tlm_start(snap, now);
+  tlm_last = *snap;
+  tlm_prev = now;
+  if (tlm_n == TELEM_MAX) telem_flush();
+}
+
+/* Close and send the current frame */
+void telem_flush(void) {
+  U16 crc;
+
+  if (tlm_len == 0) return;
+  tlm_buf[8] = (U8)tlm_n;
+  crc = crc16(tlm_buf, tlm_len);
+  tlm_buf[tlm_len++] = (U8)crc;
+  tlm_buf[tlm_len++] = (U8)(crc >> 8);
+  if (ser_txfree() >= tlm_len) {
+    ser_write(tlm_buf, tlm_len);
+  } else {
+    tlm_dropped++;
+  }
+  tlm_seq++;
+  tlm_len = 0;
+  tlm_n   = 0;
+}
+
+/* Ticks until the open frame times out (0xFFFF if none is open) */
+U16 telem_left(void) {
+  S32 d;
+
+  if (tlm_len == 0) return 0xFFFF;
+  d = TELEM_FLUSH - (S32)(U16)(os_time_get() - tlm_first);
+  return (d > 0) ? (U16)d : 0;
+}
+
+/* Frames dropped because the TX ring was full */
+U32 telem_drops(void) {
+  return tlm_dropped;
+}
@@ -0,0 +1,34 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Telemetry frame definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __TELEM_H
+#define __TELEM_H
+
+#define TELEM_SYNC      0x7E
+#define TELEM_VER       1
+#define TELEM_MAX       32          /* samples per frame */
+#define TELEM_FLUSH     500         /* ticks from first sample to flush */
+
+/* Frame, all fields little-endian:
+
+     U8  sync, ver
+     U16 seq
+     U32 time           tick of the first sample
+     U8  n              samples in the frame
+     U8  temp, light, motion              first sample
+     n-1 x { U8 dt; S8 dtemp; U8 dlight << 1 | motion }
+     U16 crc            CRC-16/CCITT (0xFFFF) of all bytes before it
+
+   dt is in ticks from the previous sample, dlight a 7 bit signed delta.
+   A sample that does not fit the deltas starts a new frame. */
+#define TELEM_HDR       12
+#define TELEM_SAMPLE    3
+#define TELEM_FRAME     (TELEM_HDR + (TELEM_MAX - 1) * TELEM_SAMPLE + 2)
+
+extern void telem_add (const SENS_SNAP *snap);
+extern void telem_flush (void);
+extern U16  telem_left (void);
+extern U32  telem_drops (void);
+
+#endif
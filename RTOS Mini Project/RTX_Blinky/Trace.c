@@ -0,0 +1,77 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Binary trace
+ *
+ *  A ring of TRC_LEN 8-byte records written from tasks and ISRs. The only
+ *  shared state is the free-running head index; it is claimed with every
+ *  VIC source masked (vic_lock(), Vic.c) for a few instructions, after
+ *  which the record is filled in place without any kernel call. A writer that is interrupted while
+ *  filling its record cannot collide with the interrupting one, which
+ *  claims the next slot. The oldest records are overwritten.
+ *
+ *  trace_dump() writes the ring to UART0, oldest record first:
+ *
+ *    "TRC" version(1) clk_hz(U32) count(U16) rec_size(U16) records...
+ *
+ *  all little-endian. Recording is paused while the dump runs; the caller
+ *  sleeps whenever the UART ring is full.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Clock.h"
+#include "Serial.h"
+#include "Vic.h"
+#include "Trace.h"
+
+#if (TRACE_ENABLE)
+static TRC_REC trc_buf[TRC_LEN];
+static volatile U32 trc_head;       /* records written since reset */
+static volatile U8  trc_off;        /* paused by trace_dump() */
+
+/* Append one record */
+void trace_put(U32 ev, U32 arg, U32 data) {
+  TRC_REC *r;
+  U32 i, was;
+
+  if (trc_off) return;
+  was = vic_lock(VIC_ALL);
+  i = trc_head++;
+  vic_unlock(was);
+
+  r = &trc_buf[i & (TRC_LEN - 1)];
+  r->time = clk_now();
+  r->ev   = (U8)ev;
+  r->arg  = (U8)arg;
+  r->data = (U16)data;
+}
+
+/* Drop all records */
+void trace_reset(void) {
+  trc_head = 0;
+}
+
+/* Binary dump of all valid records over UART0 */
+void trace_dump(void) {
+  U8  hdr[12];
+  U32 i, n, first;
+
+  trc_off = 1;
+  n     = (trc_head < TRC_LEN) ? trc_head : TRC_LEN;
+  first = trc_head - n;
+
+  hdr[0]  = 'T'; hdr[1] = 'R'; hdr[2] = 'C'; hdr[3] = 1;
+  hdr[4]  = (U8)(CLK_HZ);
+  hdr[5]  = (U8)(CLK_HZ >> 8);
+  hdr[6]  = (U8)(CLK_HZ >> 16);
+  hdr[7]  = (U8)(CLK_HZ >> 24);
+  hdr[8]  = (U8)n;
+  hdr[9]  = (U8)(n >> 8);
+  hdr[10] = sizeof(TRC_REC);
+  hdr[11] = 0;
+  ser_send(hdr, sizeof(hdr));
+  for (i = 0; i < n; i++) {
+    ser_send(&trc_buf[(first + i) & (TRC_LEN - 1)], sizeof(TRC_REC));
+  }
+  trc_off = 0;
+}
+#endif
@@ -0,0 +1,48 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Binary trace definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "Config.h"                 /* TRACE_ENABLE: 0 compiles it all out */
+
+#define TRC_LEN         256         /* records, power of 2 */
+
+/* Events (arg / data) */
+#define TRC_SWITCH      1           /* task seen running (tid / -), sampled */
+#define TRC_ISR         2           /* ISR entry (VIC channel / info) */
+#define TRC_MUT_WAIT    3           /* mutex wait (object / tid) */
+#define TRC_MUT_GOT     4           /* mutex taken (object / tid) */
+#define TRC_MUT_TMO     5           /* mutex wait timed out (object / tid) */
+#define TRC_MUT_REL     6           /* mutex released (object / tid) */
+#define TRC_RES_BLOCK   7           /* res_lock() blocks (tid / holder) */
+#define TRC_RES_LOCK    8           /* res_lock() granted (tid / ceiling) */
+#define TRC_RES_UNLOCK  9           /* res_unlock() (tid / ceiling) */
+#define TRC_MBX_SEND    10          /* log record sent (source / id) */
+#define TRC_MBX_DROP    11          /* log record dropped (source / drops) */
+#define TRC_SCR_POST    12          /* LCD request (SCR_EVT_xxx / tid) */
+#define TRC_SCR_DRAW    13          /* LCD frame drawn (alarm / cells left) */
+#define TRC_HB_LATE     14          /* task missed its heartbeat (tid / ticks) */
+
+/* Trace record, 8 bytes */
+typedef struct {
+  U32  time;                        /* clk_now() */
+  U8   ev;                          /* TRC_xxx */
+  U8   arg;
+  U16  data;
+} TRC_REC;
+
+#if (TRACE_ENABLE)
+#define TRACE(ev, arg, data)  trace_put((ev), (arg), (data))
+
+extern void trace_put (U32 ev, U32 arg, U32 data);
+extern void trace_reset (void);
+extern void trace_dump (void);
+#else
+#define TRACE(ev, arg, data)
+#define trace_reset()
+#define trace_dump()
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Interrupt source masking
+ *
+ *  Tasks run in User mode, where __disable_irq() has no effect, so short
+ *  critical sections shared with interrupt handlers mask the sources
+ *  involved at the VIC instead. Masking the RTX tick (VIC_TICK) also
+ *  keeps the task switch out: on the ARM7 every preemption goes through
+ *  the tick interrupt, as tsk_lock() does it.
+ *
+ *  vic_lock() returns which of the masked sources were enabled and
+ *  vic_unlock() enables just those again, so sections nest and may be
+ *  entered from handlers as well as from tasks. A section must be a few
+ *  instructions of plain code: no RTX call (the kernel enables the tick
+ *  on its own, see tsk_unlock()), and no handler may enable a source
+ *  while one is open.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Vic.h"
+
+#ifndef VIC_ENABLED
+#define VIC_ENABLED     VICIntEnable    /* read: sources enabled */
+#endif
+
+/* Mask the sources in 'mask'; returns those that were enabled */
+U32 vic_lock(U32 mask) {
+  U32 was = VIC_ENABLED & mask;
+
+  VICIntEnClr = mask;
+  return was;
+}
+
+/* Enable again what vic_lock() masked */
+void vic_unlock(U32 was) {
+  if (was) VICIntEnable = was;
+}
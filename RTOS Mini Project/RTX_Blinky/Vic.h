@@ -0,0 +1,24 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Interrupt source masking definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __VIC_H
+#define __VIC_H
+
+/* VIC sources (VICIntEnable bits) */
+#define VIC_TICK        (1 << 4)    /* Timer 0, the RTX tick: task switches */
+#define VIC_TIMER1      (1 << 5)    /* Clock.c, timer wheel */
+#define VIC_UART0       (1 << 6)
+#define VIC_EINT0       (1 << 14)
+#define VIC_ADC         (1 << 18)
+#define VIC_TIMER2      (1 << 26)   /* LCD transfer engine */
+#define VIC_TIMER3      (1 << 27)   /* ADC pacing */
+#define VIC_ALL         0xFFFFFFFF
+
+/* Everything a timer wheel function may share with tasks */
+#define VIC_WHEEL       (VIC_TICK | VIC_TIMER1)
+
+extern U32  vic_lock (U32 mask);
+extern void vic_unlock (U32 was);
+
+#endif
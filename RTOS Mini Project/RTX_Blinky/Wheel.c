@@ -0,0 +1,177 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Timer wheel
+ *
+ *  Software timers hashed by expiry tick into WHEEL_SLOTS lists, so
+ *  starting, stopping and expiring a timer costs the same for any number
+ *  of timers. A timer further out than one turn waits in its slot until
+ *  its round comes up.
+ *
+ *  The wheel has no task of its own: it runs from the Timer 1 MR1 match
+ *  interrupt (Clock.c), and MR1 is pointed at the next slot that holds a
+ *  timer, so an empty stretch costs no interrupts and tickless idle
+ *  sleeps through it. Wheel ticks are CLK_PER_TICK long, the RTX tick
+ *  length but not in phase with the RTX tick. (RTX user timers were the
+ *  other way in: os_tmr_call() may only use isr_ functions, so it cannot
+ *  create the next user timer, and re-arming would need a task again.)
+ *
+ *  Timer functions are called in the interrupt. They may use isr_ RTX
+ *  functions, out_set()/out_release() and wheel_start()/wheel_stop(),
+ *  and should be short: hand anything longer to a task. A periodic timer
+ *  keeps its phase; releases missed by a late interrupt are skipped, not
+ *  repeated. A timer stopped by the function of another timer expiring
+ *  in the same interrupt still has its own function called once.
+ *
+ *  The lists are guarded by masking the tick and Timer 1 at the VIC
+ *  (VIC_WHEEL, Vic.c), so timers may be started and stopped from tasks
+ *  and from interrupt handlers.
+ *----------------------------------------------------------------------------*/
+
+#include <RTL.h>
+#include <LPC23xx.H>
+#include "Clock.h"
+#include "Vic.h"
+#include "Wheel.h"
+
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+#define WHEEL_MR1I      (1 << 3)          /* T1MCR: interrupt on MR1 */
+#define WHEEL_LEAD      (CLK_PER_US * 20) /* earliest MR1 match from now */
+
+static WHEEL_TMR *wheel_slot[WHEEL_SLOTS];
+static U16 wheel_pos;               /* last tick handled by the interrupt */
+static U32 wheel_base;              /* clk_now() at the start of wheel_pos */
+static U32 wheel_cnt;               /* armed timers */
+
+static void wheel_insert(WHEEL_TMR *t) {
+  WHEEL_TMR **s = &wheel_slot[t->due & WHEEL_MASK];
+
+  t->next  = *s;
+  *s       = t;
+  t->armed = 1;
+  wheel_cnt++;
+}
+
+static void wheel_remove(WHEEL_TMR *t) {
+  WHEEL_TMR **pp = &wheel_slot[t->due & WHEEL_MASK];
+
+  while (*pp != t) pp = &(*pp)->next;
+  *pp      = t->next;
+  t->armed = 0;
+  wheel_cnt--;
+}
+
+/* Current tick. An empty wheel restarts its time base here: nothing
+   depends on the phase then, and the clk_now() difference stays far
+   below the Timer 1 wrap. Called with VIC_WHEEL masked. */
+static U16 wheel_now(void) {
+  U32 now = clk_now();
+
+  if (wheel_cnt == 0) {
+    wheel_base = now;
+    return wheel_pos;
+  }
+  return wheel_pos + (U16)((now - wheel_base) / CLK_PER_TICK);
+}
+
+/* Point MR1 at the next slot that holds a timer (which may belong to a
+   later turn), or stop it when the wheel is empty. Never sets a match
+   that has already gone by: the counter would have to wrap to reach it.
+   Called with VIC_WHEEL masked. */
+static void wheel_arm(void) {
+  U32 i, at;
+
+  if (wheel_cnt == 0) {
+    T1MCR &= ~WHEEL_MR1I;
+    return;
+  }
+  for (i = 1; i < WHEEL_SLOTS && wheel_slot[(wheel_pos + i) & WHEEL_MASK] == NULL; i++);
+  at = wheel_base + i * CLK_PER_TICK;
+  if ((S32)(at - clk_now()) < WHEEL_LEAD) at = clk_now() + WHEEL_LEAD;
+  T1MR1  = at;
+  T1MCR |= WHEEL_MR1I;
+}
+
+/* MR1 match: expire every timer due up to the current tick */
+static void wheel_irq(void) {
+  WHEEL_TMR *fire = NULL;
+  WHEEL_TMR **pp, *t;
+  U16 now, n, pos;
+
+  now = wheel_now();
+  n   = (U16)(now - wheel_pos);
+  wheel_base += n * CLK_PER_TICK;
+  if (n > WHEEL_SLOTS) n = WHEEL_SLOTS;   /* one turn visits every slot */
+  pos = now - n;
+  while (n--) {
+    pp = &wheel_slot[++pos & WHEEL_MASK];
+    while ((t = *pp) != NULL) {
+      if ((S16)(t->due - now) > 0) {
+        pp = &t->next;
+        continue;
+      }
+      *pp      = t->next;
+      t->armed = 0;
+      wheel_cnt--;
+      if (t->period) {
+        /* re-arm now, in a slot this scan skips (due > now) */
+        do {
+          t->due += t->period;
+        } while ((S16)(t->due - now) <= 0);
+        wheel_insert(t);
+      }
+      t->link = fire;
+      fire    = t;
+    }
+  }
+  wheel_pos = now;
+
+  /* after the scan: a function may start or stop any timer */
+  while ((t = fire) != NULL) {
+    fire = t->link;
+    t->fn(t);
+  }
+  wheel_arm();
+}
+
+/* Take the Timer 1 MR1 interrupt (call from init after clk_init, before
+   the first wheel_start) */
+void wheel_init(void) {
+  wheel_pos  = 0;
+  wheel_base = clk_now();
+  clk_attach(1, wheel_irq);
+}
+
+/* Set up a timer once before its first wheel_start() */
+void wheel_tmr_init(WHEEL_TMR *t, WHEEL_FN fn, void *arg) {
+  t->next   = NULL;
+  t->link   = NULL;
+  t->fn     = fn;
+  t->arg    = arg;
+  t->period = 0;
+  t->armed  = 0;
+}
+
+/* (Re)arm: first expiry 'delay' ticks from now (at least 1), then every
+   'period' ticks unless period is 0 */
+void wheel_start(WHEEL_TMR *t, U16 delay, U16 period) {
+  U32 was;
+
+  was = vic_lock(VIC_WHEEL);
+  if (t->armed) wheel_remove(t);
+  t->due    = wheel_now() + (delay ? delay : 1);
+  t->period = period;
+  wheel_insert(t);
+  wheel_arm();
+  vic_unlock(was);
+}
+
+/* Disarm; no effect on a timer that is not armed */
+void wheel_stop(WHEEL_TMR *t) {
+  U32 was;
+
+  was = vic_lock(VIC_WHEEL);
+  if (t->armed) {
+    wheel_remove(t);
+    wheel_arm();
+  }
+  vic_unlock(was);
+}
@@ -0,0 +1,29 @@
+/*----------------------------------------------------------------------------
+ *  Smart Home System - Timer wheel definitions
+ *----------------------------------------------------------------------------*/
+
+#ifndef __WHEEL_H
+#define __WHEEL_H
+
+#define WHEEL_SLOTS     64          /* ticks per turn, power of 2 */
+
+typedef struct wheel_tmr WHEEL_TMR;
+typedef void (*WHEEL_FN)(WHEEL_TMR *t);
+
+/* One software timer, owned by the caller */
+struct wheel_tmr {
+  WHEEL_TMR *next;                  /* slot list */
+  WHEEL_TMR *link;                  /* expired list of the interrupt */
+  WHEEL_FN   fn;                    /* called on expiry, in the interrupt */
+  void      *arg;
+  U16        due;                   /* wheel tick of the expiry */
+  U16        period;                /* [ticks], 0 = one-shot */
+  U8         armed;
+};
+
+extern void wheel_init (void);
+extern void wheel_tmr_init (WHEEL_TMR *t, WHEEL_FN fn, void *arg);
+extern void wheel_start (WHEEL_TMR *t, U16 delay, U16 period);
+extern void wheel_stop (WHEEL_TMR *t);
+
+#endif